@@ -0,0 +1,66 @@
+// arena.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+#include <ulpcl/arena.hpp>
+
+namespace mjx {
+    arena::arena() noexcept : _Myblocks(), _Mynext(nullptr), _Myleft(0) {}
+
+    arena::~arena() noexcept {}
+
+    inline unsigned char* _Align_pointer(unsigned char* const _Ptr, const size_t _Align) noexcept {
+        // returns the first address at or after _Ptr that is a multiple of _Align (power of two)
+        const uintptr_t _Addr = reinterpret_cast<uintptr_t>(_Ptr);
+        return _Ptr + (((_Addr + (_Align - 1)) & ~static_cast<uintptr_t>(_Align - 1)) - _Addr);
+    }
+
+    unsigned char* arena::_Allocate_block(const size_type _Size) {
+        _Myblocks.push_back(pool_resource(_Size));
+        return static_cast<unsigned char*>(_Myblocks.back().data());
+    }
+
+    arena::pointer arena::allocate(const size_type _Count) {
+        return allocate_aligned(_Count, alignof(::std::max_align_t));
+    }
+
+    arena::pointer arena::allocate_aligned(const size_type _Count, const size_type _Align) {
+        if (_Mynext) { // try to use the current shared block
+            unsigned char* const _Ptr = _Align_pointer(_Mynext, _Align);
+            const size_type _Used     = static_cast<size_type>(_Ptr - _Mynext) + _Count;
+            if (_Used <= _Myleft) { // fits in the current shared block
+                _Mynext  = _Ptr + _Count;
+                _Myleft -= _Used;
+                return _Ptr;
+            }
+        }
+
+        if (_Count + _Align > _Max_shared) { // too large to be shared, allocate a separate block
+            return _Align_pointer(_Allocate_block(_Count + _Align), _Align);
+        }
+
+        unsigned char* const _Block = _Allocate_block(_Block_size);
+        unsigned char* const _Ptr   = _Align_pointer(_Block, _Align);
+        _Mynext                     = _Ptr + _Count;
+        _Myleft                     = static_cast<size_type>(_Block + _Block_size - _Mynext);
+        return _Ptr;
+    }
+
+    void arena::deallocate(pointer, const size_type) noexcept {}
+
+    arena::size_type arena::max_size() const noexcept {
+        return static_cast<size_type>(-1) - _Block_size;
+    }
+
+    bool arena::is_equal(const allocator& _Other) const noexcept {
+        return this == ::std::addressof(_Other);
+    }
+
+    void arena::release() noexcept {
+        _Myblocks.clear();
+        _Mynext = nullptr;
+        _Myleft = 0;
+    }
+} // namespace mjx
\ No newline at end of file
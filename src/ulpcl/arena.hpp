@@ -0,0 +1,127 @@
+// arena.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_ARENA_HPP_
+#define _ULPCL_ARENA_HPP_
+#include <cstddef>
+#include <mjmem/allocator.hpp>
+#include <mjmem/pool_resource.hpp>
+#include <mjstr/string_view.hpp>
+#include <type_traits>
+#include <ulpcl/utils.hpp>
+
+namespace mjx {
+    class arena : public allocator { // monotonic allocator that releases all its memory at once
+    public:
+        using value_type      = allocator::value_type;
+        using size_type       = allocator::size_type;
+        using difference_type = allocator::difference_type;
+        using pointer         = allocator::pointer;
+
+        arena() noexcept;
+        ~arena() noexcept override;
+
+        arena(const arena&)            = delete;
+        arena& operator=(const arena&) = delete;
+
+        // allocates uninitialized storage
+        pointer allocate(const size_type _Count) override;
+
+        // allocates uninitialized storage with the specifed alignment
+        pointer allocate_aligned(const size_type _Count, const size_type _Align) override;
+
+        // does nothing, the storage is deallocated when the arena is released
+        void deallocate(pointer _Ptr, const size_type _Count) noexcept override;
+
+        // returns the largest supported allocation size
+        size_type max_size() const noexcept override;
+
+        // compares for equality with another allocator
+        bool is_equal(const allocator& _Other) const noexcept override;
+
+        // copies the string into the arena, no encoding conversion is performed
+        template <class _To, class _From>
+        string_view<_To> copy_string(const string_view<_From> _Str) {
+            _To* const _Data = static_cast<_To*>(allocate_aligned(_Str.size() * sizeof(_To), alignof(_To)));
+            for (size_t _Idx = 0; _Idx < _Str.size(); ++_Idx) {
+                _Data[_Idx] = static_cast<_To>(_Str[_Idx]);
+            }
+
+            return string_view<_To>{_Data, _Str.size()};
+        }
+
+        // releases all the allocated storage
+        void release() noexcept;
+
+    private:
+        static constexpr size_type _Block_size = 64 * 1024;
+        static constexpr size_type _Max_shared = _Block_size / 4; // larger allocations get separate blocks
+
+        // allocates a new block with the specified size
+        unsigned char* _Allocate_block(const size_type _Size);
+
+        // Note: Each block is a separate pool resource. Small allocations are carved out of the last
+        //       shared block, while large ones get blocks of their own, so that the space left
+        //       in the shared block is not wasted.
+        vector<pool_resource> _Myblocks;
+        unsigned char* _Mynext; // the first free byte of the current shared block
+        size_type _Myleft; // the number of free bytes in the current shared block
+    };
+
+    template <class _Ty>
+    class arena_allocator { // type-specific wrapper around an arena
+    public:
+        using value_type      = _Ty;
+        using size_type       = arena::size_type;
+        using difference_type = arena::difference_type;
+        using pointer         = _Ty*;
+        using const_pointer   = const _Ty*;
+        using reference       = _Ty&;
+        using const_reference = const _Ty&;
+
+        using propagate_on_container_copy_assignment = ::std::true_type;
+        using propagate_on_container_move_assignment = ::std::true_type;
+        using propagate_on_container_swap            = ::std::true_type;
+
+        template <class _Other>
+        struct rebind {
+            using other = arena_allocator<_Other>;
+        };
+
+        // Note: A default-constructed allocator is not bound to any arena, it can be used only
+        //       by empty containers that are going to be assigned later.
+        arena_allocator() noexcept : _Myarena(nullptr) {}
+
+        arena_allocator(arena& _Arena) noexcept : _Myarena(::std::addressof(_Arena)) {}
+
+        template <class _Other>
+        arena_allocator(const arena_allocator<_Other>& _Al) noexcept : _Myarena(_Al._Get_arena()) {}
+
+        pointer allocate(const size_type _Count) {
+            return static_cast<pointer>(_Myarena->allocate_aligned(_Count * sizeof(_Ty), alignof(_Ty)));
+        }
+
+        void deallocate(pointer, const size_type) noexcept {} // released with the arena
+
+        // returns the associated arena
+        arena* _Get_arena() const noexcept {
+            return _Myarena;
+        }
+
+    private:
+        arena* _Myarena;
+    };
+
+    template <class _Ty, class _Other>
+    inline bool operator==(const arena_allocator<_Ty>& _Left, const arena_allocator<_Other>& _Right) noexcept {
+        return _Left._Get_arena() == _Right._Get_arena();
+    }
+
+    template <class _Ty>
+    using arena_vector = ::std::vector<_Ty, arena_allocator<_Ty>>;
+} // namespace mjx
+
+#endif // _ULPCL_ARENA_HPP_
\ No newline at end of file
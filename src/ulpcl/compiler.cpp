@@ -3,10 +3,13 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
+#include <cstring>
 #include <mjfs/status.hpp>
 #include <mjstr/conversion.hpp>
 #include <type_traits>
 #include <ulpcl/compiler.hpp>
+#include <ulpcl/id_map.hpp>
 #include <ulpcl/lexer.hpp>
 #include <ulpcl/logger.hpp>
 #include <ulpcl/program.hpp>
@@ -19,38 +22,8 @@ namespace mjx {
         return path{program_options::current().output_directory / _Pack}.replace_extension(L".umc");
     }
 
-    vector<message> _Get_messages_from_group(const group& _Group, const utf8_string& _Namespace) {
-        vector<message> _Messages;
-        _Messages.reserve(_Group.messages.size()); // pre-allocate space for the messages from this group
-        for (const message& _Message : _Group.messages) { // get messages from the current group
-            _Messages.push_back(message{_Namespace + _Message.id, _Message.value});
-        }
-
-        for (const group& _Child_group : _Group.groups) {
-            const vector<message>& _Child_messages = _Get_messages_from_group(
-                _Child_group, _Namespace + '.' + _Child_group.name); // recurse into child group
-            _Messages.insert(_Messages.end(), _Child_messages.begin(), _Child_messages.end());
-        }
-
-        return ::std::move(_Messages);
-    }
-
-    vector<message> _Get_messages_from_content(const root_group& _Content) {
-        vector<message> _Messages = _Content.messages;
-        for (const group& _Child_group : _Content.groups) {
-            const vector<message>& _Child_messages = _Get_messages_from_group(_Child_group, _Child_group.name);
-            _Messages.insert(_Messages.end(), _Child_messages.begin(), _Child_messages.end());
-        }
-
-        return ::std::move(_Messages);
-    }
-
-    uint64_t _Compute_hash(const utf8_string_view _Id) noexcept {
-        return ::XXH3_64bits(_Id.data(), _Id.size());
-    }
-
     _Umc_file::_Umc_file(const path& _Target, report_counters& _Counters)
-        : _Myfile(), _Mystream(), _Myctrs(_Counters) {
+        : _Myfile(), _Mystream(), _Myctrs(_Counters), _Mybuf(), _Mysize(0) {
         if (::mjx::exists(_Target)) { // open an existing file
             _Open(_Target);
         } else { // create a new file
@@ -84,96 +57,635 @@ namespace mjx {
         return _Mystream.is_open();
     }
 
+    size_t _Umc_file::_Header_size(const byte_string_view _Language) noexcept {
+        // signature, language length and name, LCID and the number of messages
+        return _Umc_layout::_Signature_length + 1 + _Language.size() + sizeof(uint32_t) + sizeof(uint32_t);
+    }
+
+    void _Umc_file::_Reserve(const size_t _Size) {
+        _Mybuf.reserve(_Size);
+        _Mysize = _Size;
+    }
+
     uint64_t _Umc_file::_Current_offset() const noexcept {
-        return _Mystream.is_open() ? _Mystream.tell() : 0;
+        return _Mystream.is_open() ? _Mybuf.size() : 0;
     }
 
-    bool _Umc_file::_Write_signature() noexcept {
-        if (!_Mystream.is_open()) { // stream must be open, break
+    bool _Umc_file::_Append(const void* const _Data, const size_t _Size) noexcept {
+        if (!_Mystream.is_open() || _Mysize - _Mybuf.size() < _Size) { // stream must be open and data must fit
             return false;
         }
 
-        constexpr size_t _Signature_length             = 4;
-        constexpr byte_t _Signature[_Signature_length] = {'U', 'M', 'C', '\0'};
-        return _Mystream.write(_Signature, _Signature_length);
+        // Note: Since the reserved size is never exceeded, appending does not reallocate the buffer
+        //       and therefore cannot throw.
+        _Mybuf.append(static_cast<const byte_t*>(_Data), _Size);
+        return true;
     }
 
-    bool _Umc_file::_Write_language(const unicode_string_view _Language) {
-        if (!_Mystream.is_open()) { // stream must be open, break
-            return false;
-        }
-        
+    bool _Umc_file::_Write_signature(const byte_t _Flags) noexcept {
+        const byte_t _Signature[_Umc_layout::_Signature_length] = {'U', 'M', 'C', _Flags};
+        return _Append(_Signature, _Umc_layout::_Signature_length);
+    }
+
+    bool _Umc_file::_Write_language(const byte_string_view _Language) noexcept {
         // assumes that the length of _Language in UTF-8 encoding fit in 8-bit integer
-        const byte_string& _Bytes = ::mjx::to_byte_string(_Language);
-        const byte_t _Length      = static_cast<byte_t>(_Bytes.size());
-        return _Mystream.write(&_Length, 1) && _Mystream.write(_Bytes);
+        const byte_t _Length = static_cast<byte_t>(_Language.size());
+        return _Append(&_Length, 1) && _Append(_Language.data(), _Language.size());
     }
 
     bool _Umc_file::_Write_lcid(const uint32_t _Lcid) noexcept {
-        if (!_Mystream.is_open()) { // stream must be open, break
-            return false;
-        }
-
-        return _Mystream.write(reinterpret_cast<const byte_t*>(&_Lcid), sizeof(uint32_t));
+        return _Append(&_Lcid, sizeof(uint32_t));
     }
 
     bool _Umc_file::_Write_message_count(const uint32_t _Count) noexcept {
-        if (!_Mystream.is_open()) { // stream must be open, break
-            return false;
-        }
+        return _Append(&_Count, sizeof(uint32_t));
+    }
 
-        return _Mystream.write(reinterpret_cast<const byte_t*>(&_Count), sizeof(uint32_t));
+    bool _Umc_file::_Align_section() noexcept {
+        static constexpr byte_t _Zeros[_Umc_layout::_Section_alignment] = {0};
+
+        const uint64_t _Offset = _Current_offset();
+        return _Append(_Zeros, static_cast<size_t>(_Umc_layout::_Align_offset(_Offset) - _Offset));
     }
 
-    bool _Umc_file::_Write_lookup_table_entry(const _Lookup_table_entry _Entry) noexcept {
-        if (!_Mystream.is_open()) { // stream must be open, break
+    bool _Umc_file::_Write_perfect_hash_index(const uint64_t _Seed, const vector<uint32_t>& _Pilots) noexcept {
+#ifdef _M_X64
+        const uint32_t _Count = static_cast<uint32_t>(_Pilots.size());
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+        const uint32_t _Count = _Pilots.size();
+#endif // _M_X64
+        return _Append(&_Seed, sizeof(uint64_t)) && _Append(&_Count, sizeof(uint32_t))
+            && _Append(_Pilots.data(), _Pilots.size() * sizeof(uint32_t));
+    }
+
+    bool _Umc_file::_Write_symbol_table(const fsst_table& _Table) noexcept {
+        // the number of symbols, their lengths and their bytes
+        const byte_t _Count = static_cast<byte_t>(_Table.size());
+        if (!_Append(&_Count, 1)) {
             return false;
         }
 
+        for (size_t _Code = 0; _Code < _Table.size(); ++_Code) {
+            const byte_t _Length = static_cast<byte_t>(_Table.symbol(_Code).size());
+            if (!_Append(&_Length, 1)) {
+                return false;
+            }
+        }
+
+        for (size_t _Code = 0; _Code < _Table.size(); ++_Code) {
+            const byte_string_view _Symbol = _Table.symbol(_Code);
+            if (!_Append(_Symbol.data(), _Symbol.size())) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool _Umc_file::_Write_block_index(const vector<_Block_index_entry>& _Blocks) noexcept {
+#ifdef _M_X64
+        const uint32_t _Count = static_cast<uint32_t>(_Blocks.size());
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+        const uint32_t _Count = _Blocks.size();
+#endif // _M_X64
+        return _Append(&_Count, sizeof(uint32_t))
+            && _Append(_Blocks.data(), _Blocks.size() * sizeof(_Block_index_entry));
+    }
+
+    bool _Umc_file::_Write_ordinal_count(const uint32_t _Count) noexcept {
+        return _Append(&_Count, sizeof(uint32_t));
+    }
+
+    bool _Umc_file::_Write_lookup_table_entry(const _Lookup_table_entry _Entry) noexcept {
         // Note: Given that _Lookup_table_entry is aligned to 4-byte boundary without padding,
         //       it is safe to reinterpret_cast _Entry to a byte sequence. This is because
         //       _Lookup_table_entry stores integers, which can be directly converted to raw bytes.
-        return _Mystream.write(reinterpret_cast<const byte_t*>(&_Entry), sizeof(_Lookup_table_entry));
+        return _Append(&_Entry, sizeof(_Lookup_table_entry));
+    }
+
+    bool _Umc_file::_Write_lookup_table_entry(const _Compressed_lookup_table_entry _Entry) noexcept {
+        return _Append(&_Entry, sizeof(_Compressed_lookup_table_entry));
+    }
+
+    bool _Umc_file::_Write_hash(const uint64_t _Hash) noexcept {
+        return _Append(&_Hash, sizeof(uint64_t));
+    }
+
+    bool _Umc_file::_Write_value_location(const _Value_location _Location) noexcept {
+        return _Append(&_Location, sizeof(_Value_location));
+    }
+
+    bool _Umc_file::_Write_value_location(const _Compressed_value_location _Location) noexcept {
+        return _Append(&_Location, sizeof(_Compressed_value_location));
     }
 
     bool _Umc_file::_Write_message_value(const byte_string_view _Value) noexcept {
-        if (!_Mystream.is_open()) { // stream must be open, break
+        return _Append(_Value.data(), _Value.size());
+    }
+
+    bool _Umc_file::_Commit() noexcept {
+        if (!_Mystream.is_open() || _Mybuf.size() != _Mysize) { // the whole image must be serialized, break
             return false;
         }
-        
-        return _Mystream.write(_Value);
+
+        return _Mystream.write(_Mybuf);
     }
 
-    _Section_writer::_Section_writer(_Umc_file& _File, const vector<message>& _Messages)
-        : _Myfile(_File), _Mymsgs(_Convert_messages(_Messages)) {}
+    _Section_writer::_Section_writer(_Umc_file& _File, const arena_vector<message>& _Messages)
+        : _Myfile(_File), _Mymsgs(_Convert_messages(_Messages)), _Myblob(), _Myblob_size(0),
+        _Myflags(_Umc_flags::_None), _Myindex(), _Mytable(), _Mycompressed(), _Myblocks(), _Myordinals(0) {}
 
     _Section_writer::~_Section_writer() noexcept {}
 
-    vector<_Section_writer::_Writable_message> _Section_writer::_Convert_messages(const vector<message>& _Messages) {
+    vector<_Section_writer::_Writable_message> _Section_writer::_Convert_messages(
+        const arena_vector<message>& _Messages) {
         vector<_Writable_message> _Writable_messages;
         _Writable_messages.reserve(_Messages.size()); // pre-allocate space for converted messages
-        for (const message& _Message : _Messages) {
+        for (size_t _Idx = 0; _Idx < _Messages.size(); ++_Idx) {
             _Writable_messages.push_back(
-                _Writable_message{_Compute_hash(_Message.id), ::mjx::to_byte_string(_Message.value)});
+                _Writable_message{_Messages[_Idx].hash, _Messages[_Idx].value, static_cast<uint32_t>(_Idx)});
+#ifdef _M_X64
+            _Writable_messages.back()._Length = static_cast<uint32_t>(_Messages[_Idx].value.size());
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+            _Writable_messages.back()._Length = _Messages[_Idx].value.size();
+#endif // _M_X64
         }
 
         return ::std::move(_Writable_messages);
     }
 
-    bool _Section_writer::_Write_lookup_table() noexcept {
-        _Lookup_table_entry _Entry;
+    void _Section_writer::_Sort_messages() noexcept {
+        // Note: Messages with equal hashes are ordered by their indices, so that the order is deterministic.
+        //       The blob follows the lookup table order, as the values are pooled afterwards.
+        ::std::sort(_Mymsgs.begin(), _Mymsgs.end(),
+            [](const _Writable_message& _Left, const _Writable_message& _Right) noexcept {
+                return _Left._Hash != _Right._Hash ? _Left._Hash < _Right._Hash : _Left._Index < _Right._Index;
+            }
+        );
+    }
+
+    bool _Section_writer::_Index_messages() {
+        vector<uint64_t> _Keys;
+        _Keys.reserve(_Mymsgs.size());
         for (const _Writable_message& _Message : _Mymsgs) {
-            _Entry._Hash   = _Message._Hash;
+            _Keys.push_back(_Message._Hash);
+        }
+
+        if (!_Myindex.build(_Keys)) { // failed to build the perfect hash function, break
+            return false;
+        }
+
+        // Note: The perfect hash function is minimal, so each message is stored in the lookup table entry
+        //       at its position. The readers find the entry directly, without any further indirection.
+        vector<_Writable_message> _Indexed(_Mymsgs.size());
+        for (const _Writable_message& _Message : _Mymsgs) {
+            _Indexed[_Myindex.position(_Message._Hash)] = _Message;
+        }
+
+        _Mymsgs = ::std::move(_Indexed);
+        return true;
+    }
+
+    void _Section_writer::_Order_messages(const parse_tree& _Tree) {
+        // Note: Each message ID has a unique ordinal, so the order is deterministic. The ordinals of
+        //       the IDs that are not declared in this pack are left out, so the messages are sparse.
+        vector<uint32_t> _Ordinals;
+        _Myordinals = id_map::current().assign(_Tree, _Ordinals);
+        for (_Writable_message& _Message : _Mymsgs) {
+            _Message._Ordinal = _Ordinals[_Message._Index];
+        }
+
+        ::std::sort(_Mymsgs.begin(), _Mymsgs.end(),
+            [](const _Writable_message& _Left, const _Writable_message& _Right) noexcept {
+                return _Left._Ordinal < _Right._Ordinal;
+            }
+        );
+    }
+
+    bool _Section_writer::_Arrange_entries(const parse_tree& _Tree) {
+        const program_options& _Options = program_options::current();
+        if (_Options.aligned_layout) { // sections start at cache line boundaries
+            _Myflags |= _Umc_flags::_Aligned_sections;
+        }
+
+        if (_Options.ordinal_ids) { // values are found by ordinals, the hashes are not needed
+            _Order_messages(_Tree);
+            _Myflags |= _Umc_flags::_Ordinal_table;
+        } else if (_Options.perfect_hash_index) { // O(1) lookup requires the lookup table to be indexed
+            if (!_Index_messages()) {
+                return false;
+            }
+
+            _Myflags |= _Umc_flags::_Perfect_hash_index;
+        } else if (_Options.sort_lookup_table) { // binary search requires the lookup table to be sorted
+            _Sort_messages();
+            _Myflags |= _Umc_flags::_Sorted_lookup_table;
+        }
+
+        _Pool_values();
+        return true;
+    }
+
+    void _Section_writer::_Merge_tails(const vector<byte_string_view>& _Values, vector<uint32_t>& _Hosts) {
+        // Note: If the values are sorted from their ends in descending order, each value that is
+        //       the tail of another value immediately follows a value that it is also the tail of.
+        //       Such values are stored within their hosts, and only the other values get hosts of their own.
+        vector<uint32_t> _Order(_Values.size());
+        for (uint32_t _Idx = 0; _Idx < _Order.size(); ++_Idx) {
+            _Order[_Idx] = _Idx;
+        }
+
+        ::std::sort(_Order.begin(), _Order.end(),
+            [&_Values](const uint32_t _Left_idx, const uint32_t _Right_idx) noexcept {
+                const byte_string_view _Left  = _Values[_Left_idx];
+                const byte_string_view _Right = _Values[_Right_idx];
+                const size_t _Common          = (::std::min)(_Left.size(), _Right.size());
+                size_t _Off                   = 0;
+                for (; _Off + sizeof(uint64_t) <= _Common; _Off += sizeof(uint64_t)) {
+                    // Note: On little-endian platforms, the last byte of a word is the most significant one,
+                    //       so comparing words is equivalent to comparing their bytes from the end.
+                    uint64_t _Left_word;
+                    uint64_t _Right_word;
+                    ::memcpy(&_Left_word, _Left.data() + _Left.size() - _Off - sizeof(uint64_t), sizeof(uint64_t));
+                    ::memcpy(
+                        &_Right_word, _Right.data() + _Right.size() - _Off - sizeof(uint64_t), sizeof(uint64_t));
+                    if (_Left_word != _Right_word) {
+                        return _Left_word > _Right_word;
+                    }
+                }
+
+                for (++_Off; _Off <= _Common; ++_Off) {
+                    const byte_t _Left_ch  = _Left[_Left.size() - _Off];
+                    const byte_t _Right_ch = _Right[_Right.size() - _Off];
+                    if (_Left_ch != _Right_ch) {
+                        return _Left_ch > _Right_ch;
+                    }
+                }
+
+                return _Left.size() > _Right.size(); // longer values precede their tails
+            }
+        );
+
+        uint32_t _Host = _Order.empty() ? 0 : _Order[0];
+        for (const uint32_t _Idx : _Order) {
+            if (_Values[_Host].ends_with(_Values[_Idx])) { // stored within the current host
+                _Hosts[_Idx] = _Host;
+            } else { // becomes the next host
+                _Host = _Idx;
+            }
+        }
+    }
+
+    void _Section_writer::_Pool_values() {
+        // Note: Equal values are found using an open-addressing set of their hashes, with the load factor
+        //       at most 50%. The values are compared only if their hashes are equal.
+        struct _Slot {
+            uint64_t _Hash  = 0;
+            uint32_t _Index = 0; // index of the distinct value + 1, 0 if the slot is empty
+        };
+
+        size_t _Size = 16;
+        while (_Size < _Mymsgs.size() * 2) {
+            _Size <<= 1;
+        }
+
+        // Note: The values are visited in the order in which the messages are declared, regardless of
+        //       the order of the lookup table. Adjacent messages tend to have similar values, so keeping
+        //       them together in the blob improves block compression. If the values are indexed by ordinals,
+        //       they are stored in the ordinal order instead.
+        vector<uint32_t> _Order(_Mymsgs.size()); // messages in the declaration order
+        for (uint32_t _Idx = 0; _Idx < _Order.size(); ++_Idx) {
+            _Order[_Idx] = _Idx;
+        }
+
+        if (_Myflags & (_Umc_flags::_Sorted_lookup_table | _Umc_flags::_Perfect_hash_index)) { // entries reordered
+            ::std::sort(_Order.begin(), _Order.end(),
+                [this](const uint32_t _Left, const uint32_t _Right) noexcept {
+                    return _Mymsgs[_Left]._Index < _Mymsgs[_Right]._Index;
+                }
+            );
+        }
+
+        vector<_Slot> _Slots(_Size);
+        vector<byte_string_view> _Values; // distinct values in the order of the first use
+        vector<uint32_t> _Value_ids(_Mymsgs.size()); // index of the value of each message
+        const size_t _Mask = _Size - 1;
+        for (const uint32_t _Msg_idx : _Order) {
+            const byte_string_view _Value = _Mymsgs[_Msg_idx]._Value;
+            const uint64_t _Hash          = ::XXH3_64bits(_Value.data(), _Value.size());
+            for (size_t _Idx = static_cast<size_t>(_Hash) & _Mask;; _Idx = (_Idx + 1) & _Mask) {
+                _Slot& _Current = _Slots[_Idx];
+                if (_Current._Index == 0) { // empty slot found, the value is distinct
+                    _Values.push_back(_Value);
+                    _Current._Hash       = _Hash;
+                    _Current._Index      = static_cast<uint32_t>(_Values.size());
+                    _Value_ids[_Msg_idx] = _Current._Index - 1;
+                    break;
+                }
+
+                if (_Current._Hash == _Hash && _Values[_Current._Index - 1] == _Value) { // equal value found
+                    _Value_ids[_Msg_idx] = _Current._Index - 1;
+                    break;
+                }
+            }
+        }
+
+        vector<uint64_t> _Offsets(_Values.size());
+        if (program_options::current().compression == compression_mode::fsst) { // compress the values
+            vector<uint32_t> _Lengths(_Values.size());
+            _Compress_values(_Values, _Offsets, _Lengths);
+            for (size_t _Msg_idx = 0; _Msg_idx < _Mymsgs.size(); ++_Msg_idx) {
+                _Mymsgs[_Msg_idx]._Length = _Lengths[_Value_ids[_Msg_idx]];
+            }
+
+            _Myflags |= _Umc_flags::_Compressed_values;
+        } else { // store the values as they are
+            _Store_values(_Values, _Offsets);
+            if (program_options::current().compression == compression_mode::lz) { // compress the blob in blocks
+                _Compress_blocks();
+                _Myflags |= _Umc_flags::_Compressed_blocks;
+            }
+        }
+
+        for (size_t _Msg_idx = 0; _Msg_idx < _Mymsgs.size(); ++_Msg_idx) {
+            _Mymsgs[_Msg_idx]._Offset = _Offsets[_Value_ids[_Msg_idx]];
+        }
+    }
+
+    void _Section_writer::_Store_values(const vector<byte_string_view>& _Values, vector<uint64_t>& _Offsets) {
+        vector<uint32_t> _Hosts(_Values.size()); // value that stores each value, the value itself by default
+        for (uint32_t _Idx = 0; _Idx < _Hosts.size(); ++_Idx) {
+            _Hosts[_Idx] = _Idx;
+        }
+
+        if (program_options::current().merge_tails) { // store values within the values they are tails of
+            _Merge_tails(_Values, _Hosts);
+        }
+
+        // Note: If the blob is going to be compressed in blocks, the values are not split between blocks,
+        //       so that decompressing a single value touches only one block. Values that are longer
+        //       than _Max_block_size get blocks of their own.
+        constexpr size_t _Max_block_size = 64 * 1024;
+        const bool _Split                = program_options::current().compression == compression_mode::lz;
+        uint64_t _Block_start            = 0;
+        for (uint32_t _Idx = 0; _Idx < _Values.size(); ++_Idx) {
+            if (_Hosts[_Idx] != _Idx) { // stored within its host, skip it
+                continue;
+            }
+
+            const size_t _Size = _Values[_Idx].size();
+            if (_Split && _Myblob_size != _Block_start && _Myblob_size - _Block_start + _Size > _Max_block_size) {
+                // the value doesn't fit in the current block, start the next one
+                _Myblocks.push_back(
+                    _Block_index_entry{_Block_start, 0, static_cast<uint32_t>(_Myblob_size - _Block_start), 0});
+                _Block_start = _Myblob_size;
+            }
+
+            _Offsets[_Idx] = _Myblob_size;
+            _Myblob.push_back(_Values[_Idx]);
+            _Myblob_size  += _Size;
+        }
+
+        if (_Split && _Myblob_size != _Block_start) { // close the last block
+            _Myblocks.push_back(
+                _Block_index_entry{_Block_start, 0, static_cast<uint32_t>(_Myblob_size - _Block_start), 0});
+        }
+
+        for (uint32_t _Idx = 0; _Idx < _Values.size(); ++_Idx) {
+            const uint32_t _Host = _Hosts[_Idx];
+            if (_Host != _Idx) { // stored at the end of its host
+                _Offsets[_Idx] = _Offsets[_Host] + _Values[_Host].size() - _Values[_Idx].size();
+            }
+        }
+    }
+
+    void _Section_writer::_Compress_blocks() {
+        byte_string _Raw; // the decompressed blob
+        _Raw.reserve(_Myblob_size);
+        for (const byte_string_view _Value : _Myblob) {
+            _Raw.append(_Value);
+        }
+
+        _Mycompressed.reserve(_Myblob_size / 2); // the blocks are usually compressed at least twice
+        for (_Block_index_entry& _Block : _Myblocks) {
+            const size_t _Offset      = _Mycompressed.size();
+            ::mjx::lz_compress(byte_string_view{_Raw.data() + _Block._Offset, _Block._Length}, _Mycompressed);
+            _Block._Compressed_offset = _Offset;
+            _Block._Compressed_length = static_cast<uint32_t>(_Mycompressed.size() - _Offset);
+        }
+
+        _Myblob.clear();
+        _Myblob.push_back(_Mycompressed);
+        _Myblob_size = _Mycompressed.size();
+    }
+
+    void _Section_writer::_Compress_values(
+        const vector<byte_string_view>& _Values, vector<uint64_t>& _Offsets, vector<uint32_t>& _Lengths) {
+        // Note: The symbol table is trained over a sample of at most _Max_sample_size bytes, taken from
+        //       evenly spaced values, so that the training time doesn't depend on the size of the pack.
+        //       Each value is compressed separately, so that it can be decompressed on its own.
+        constexpr size_t _Max_sample_size = 64 * 1024;
+        size_t _Total_size                = 0;
+        for (const byte_string_view _Value : _Values) {
+            _Total_size += _Value.size();
+        }
+
+        const size_t _Stride = _Total_size / _Max_sample_size + 1;
+        vector<byte_string_view> _Sample;
+        _Sample.reserve(_Values.size() / _Stride + 1);
+        for (size_t _Idx = 0; _Idx < _Values.size(); _Idx += _Stride) {
+            _Sample.push_back(_Values[_Idx]);
+        }
+
+        _Mytable.train(_Sample);
+        _Mycompressed.reserve(_Total_size); // compressed values are usually smaller
+        for (size_t _Idx = 0; _Idx < _Values.size(); ++_Idx) {
+            const size_t _Offset = _Mycompressed.size();
+            _Mytable.compress(_Values[_Idx], _Mycompressed);
+            _Offsets[_Idx] = _Offset;
+            _Lengths[_Idx] = static_cast<uint32_t>(_Mycompressed.size() - _Offset);
+        }
+
+        _Myblob.push_back(_Mycompressed);
+        _Myblob_size = _Mycompressed.size();
+    }
+
+    size_t _Section_writer::_Section_size(const uint64_t _Offset) const noexcept {
+        const bool _Aligned     = (_Myflags & _Umc_flags::_Aligned_sections) != 0;
+        uint64_t _End           = _Offset;
+        const auto _Add_section = [_Aligned, &_End](const uint64_t _Size) noexcept {
+            _End = (_Aligned ? _Umc_layout::_Align_offset(_End) : _End) + _Size;
+        };
+
+        if (_Myflags & _Umc_flags::_Perfect_hash_index) { // seed, number of pilots and pilots
+            _Add_section(sizeof(uint64_t) + sizeof(uint32_t) + _Myindex.pilots().size() * sizeof(uint32_t));
+        }
+
+        if (_Myflags & _Umc_flags::_Compressed_values) { // number of symbols, their lengths and their bytes
+            uint64_t _Size = 1 + _Mytable.size();
+            for (size_t _Code = 0; _Code < _Mytable.size(); ++_Code) {
+                _Size += _Mytable.symbol(_Code).size();
+            }
+
+            _Add_section(_Size);
+        }
+
+        if (_Myflags & _Umc_flags::_Compressed_blocks) { // number of blocks and block index entries
+            _Add_section(sizeof(uint32_t) + _Myblocks.size() * sizeof(_Block_index_entry));
+        }
+
+        const bool _Compressed = (_Myflags & _Umc_flags::_Compressed_values) != 0;
+        if (_Myflags & _Umc_flags::_Ordinal_table) { // number of ordinals and value locations
+            _Add_section(sizeof(uint32_t) + static_cast<uint64_t>(_Myordinals)
+                * (_Compressed ? sizeof(_Compressed_value_location) : sizeof(_Value_location)));
+        } else if (_Aligned) { // hashes and value locations are stored in separate sections
+            _Add_section(_Mymsgs.size() * sizeof(uint64_t));
+            _Add_section(_Mymsgs.size()
+                * (_Compressed ? sizeof(_Compressed_value_location) : sizeof(_Value_location)));
+        } else {
+            _Add_section(_Mymsgs.size()
+                * (_Compressed ? sizeof(_Compressed_lookup_table_entry) : sizeof(_Lookup_table_entry)));
+        }
+
+        _Add_section(_Myblob_size);
+        return static_cast<size_t>(_End - _Offset);
+    }
+
+    byte_t _Section_writer::_Header_flags() const noexcept {
+        return _Myflags;
+    }
+
+    bool _Section_writer::_Write_perfect_hash_index() noexcept {
+        if (!(_Myflags & _Umc_flags::_Perfect_hash_index)) { // index not requested, do nothing
+            return true;
+        }
+
+        return _Align_section() && _Myfile._Write_perfect_hash_index(_Myindex.seed(), _Myindex.pilots());
+    }
+
+    bool _Section_writer::_Write_symbol_table() noexcept {
+        if (!(_Myflags & _Umc_flags::_Compressed_values)) { // values not compressed, do nothing
+            return true;
+        }
+
+        return _Align_section() && _Myfile._Write_symbol_table(_Mytable);
+    }
+
+    bool _Section_writer::_Write_block_index() noexcept {
+        if (!(_Myflags & _Umc_flags::_Compressed_blocks)) { // blob not compressed in blocks, do nothing
+            return true;
+        }
+
+        return _Align_section() && _Myfile._Write_block_index(_Myblocks);
+    }
+
+    bool _Section_writer::_Align_section() noexcept {
+        return !(_Myflags & _Umc_flags::_Aligned_sections) || _Myfile._Align_section();
+    }
+
+    bool _Section_writer::_Write_entry(const _Writable_message& _Message) noexcept {
+        if (_Myflags & _Umc_flags::_Compressed_values) { // describe both compressed and decoded lengths
+            _Compressed_lookup_table_entry _Entry;
+            _Entry._Hash           = _Message._Hash;
+            _Entry._Offset         = _Message._Offset;
+            _Entry._Length         = _Message._Length;
 #ifdef _M_X64
-            _Entry._Length = static_cast<uint32_t>(_Message._Value.size());
+            _Entry._Decoded_length = static_cast<uint32_t>(_Message._Value.size());
 #else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
-            _Entry._Length = _Message._Value.size();
+            _Entry._Decoded_length = _Message._Value.size();
 #endif // _M_X64
-            if (!_Myfile._Write_lookup_table_entry(_Entry)) { // failed to write lookup table entry, break
+            return _Myfile._Write_lookup_table_entry(_Entry);
+        }
+
+        _Lookup_table_entry _Entry;
+        _Entry._Hash   = _Message._Hash;
+        _Entry._Offset = _Message._Offset;
+        _Entry._Length = _Message._Length;
+        return _Myfile._Write_lookup_table_entry(_Entry);
+    }
+
+    bool _Section_writer::_Write_location(const _Writable_message& _Message) noexcept {
+        if (_Myflags & _Umc_flags::_Compressed_values) { // describe both compressed and decoded lengths
+            _Compressed_value_location _Location;
+            _Location._Offset         = _Message._Offset;
+            _Location._Length         = _Message._Length;
+#ifdef _M_X64
+            _Location._Decoded_length = static_cast<uint32_t>(_Message._Value.size());
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+            _Location._Decoded_length = _Message._Value.size();
+#endif // _M_X64
+            return _Myfile._Write_value_location(_Location);
+        }
+
+        _Value_location _Location;
+        _Location._Offset = _Message._Offset;
+        _Location._Length = _Message._Length;
+        return _Myfile._Write_value_location(_Location);
+    }
+
+    bool _Section_writer::_Write_locations() noexcept {
+        if (!_Align_section()) { // failed to align value locations, break
+            return false;
+        }
+
+        for (const _Writable_message& _Message : _Mymsgs) {
+            if (!_Write_location(_Message)) { // failed to write value location, break
                 return false;
             }
+        }
 
-            _Entry._Offset += _Entry._Length;
+        return true;
+    }
+
+    bool _Section_writer::_Write_ordinal_table(vector<symbol>* const _Symbols) noexcept {
+        if (!_Align_section() || !_Myfile._Write_ordinal_count(_Myordinals)) { // failed to write count, break
+            return false;
+        }
+
+        // Note: The messages are ordered by their ordinals, so they are written as the ordinals are visited.
+        //       The ordinals with no message in this pack get a location that is outside of every blob.
+        _Writable_message _Absent;
+        _Absent._Offset = _Umc_layout::_Absent_offset;
+        size_t _Msg_idx = 0;
+        for (uint32_t _Ordinal = 0; _Ordinal < _Myordinals; ++_Ordinal) {
+            const bool _Present = _Msg_idx < _Mymsgs.size() && _Mymsgs[_Msg_idx]._Ordinal == _Ordinal;
+            if (_Present && _Symbols) { // capture the location of the symbol
+                (*_Symbols)[_Mymsgs[_Msg_idx]._Index].location.id = _Myfile._Current_offset();
+            }
+
+            if (!_Write_location(_Present ? _Mymsgs[_Msg_idx++] : _Absent)) { // failed to write location, break
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool _Section_writer::_Write_lookup_table() noexcept {
+        if (_Myflags & _Umc_flags::_Ordinal_table) { // value locations indexed by ordinals
+            return _Write_ordinal_table(nullptr);
+        }
+
+        // Note: If the sections are aligned, the lookup table is split into two sections, an array of hashes
+        //       and an array of value locations, so that the hashes can be searched in place with aligned loads.
+        if (_Myflags & _Umc_flags::_Aligned_sections) {
+            if (!_Align_section()) { // failed to align hashes, break
+                return false;
+            }
+
+            for (const _Writable_message& _Message : _Mymsgs) {
+                if (!_Myfile._Write_hash(_Message._Hash)) { // failed to write hash, break
+                    return false;
+                }
+            }
+
+            return _Write_locations();
+        }
+
+        for (const _Writable_message& _Message : _Mymsgs) {
+            if (!_Write_entry(_Message)) { // failed to write lookup table entry, break
+                return false;
+            }
         }
 
         return true;
@@ -183,42 +695,56 @@ namespace mjx {
         if (_Symbols.size() < _Mymsgs.size()) { // not enough symbols, break
             return false;
         }
-        
-        constexpr uint64_t _Bytes_per_entry = sizeof(_Lookup_table_entry);
-        uint64_t _Abs_off                   = _Myfile._Current_offset();
-        _Lookup_table_entry _Entry;
-        for (size_t _Idx = 0; _Idx < _Mymsgs.size(); ++_Idx) {
-            const _Writable_message& _Message = _Mymsgs[_Idx];
-            _Entry._Hash                      = _Message._Hash;
-#ifdef _M_X64
-            _Entry._Length                    = static_cast<uint32_t>(_Message._Value.size());
-#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
-            _Entry._Length                    = _Message._Value.size();
-#endif // _M_X64
-            if (!_Myfile._Write_lookup_table_entry(_Entry)) { // failed to write lookup table entry, break
+
+        const bool _Aligned = (_Myflags & _Umc_flags::_Aligned_sections) != 0;
+        if (_Myflags & _Umc_flags::_Ordinal_table) { // the ID location points to the value location
+            if (!_Write_ordinal_table(&_Symbols)) { // failed to write ordinal table, break
+                return false;
+            }
+        } else {
+            if (_Aligned && !_Align_section()) { // failed to align hashes, break
                 return false;
             }
 
-            _Symbols[_Idx].location.id = _Abs_off;
-            _Abs_off                  += _Bytes_per_entry;
-            _Entry._Offset            += _Entry._Length;
+            for (const _Writable_message& _Message : _Mymsgs) {
+                // if the sections are aligned, the ID location points to the hash in the array of hashes
+                const uint64_t _Abs_off = _Myfile._Current_offset();
+                if (!(_Aligned ? _Myfile._Write_hash(_Message._Hash) : _Write_entry(_Message))) {
+                    // failed to write lookup table entry, break
+                    return false;
+                }
+
+                _Symbols[_Message._Index].location.id = _Abs_off;
+            }
+
+            if (_Aligned && !_Write_locations()) { // failed to write value locations, break
+                return false;
+            }
         }
 
         // Note: The message blob begins immediately after the lookup table, and since we have previse
-        //       information about the length of each message, we can accurately calculate the location
-        //       of the message values within this function.
-        _Abs_off = _Myfile._Current_offset();
-        for (size_t _Idx = 0; _Idx < _Mymsgs.size(); ++_Idx) {
-            _Symbols[_Idx].location.value = _Abs_off;
-            _Abs_off                     += _Mymsgs[_Idx]._Value.size();
+        //       information about the offset of each message, we can accurately calculate the location
+        //       of the message values within this function. If the blob is compressed in blocks,
+        //       the locations are relative to the decompressed blob instead.
+        uint64_t _Blob_off = 0;
+        if (!(_Myflags & _Umc_flags::_Compressed_blocks)) {
+            _Blob_off = _Aligned ? _Umc_layout::_Align_offset(_Myfile._Current_offset()) : _Myfile._Current_offset();
+        }
+
+        for (const _Writable_message& _Message : _Mymsgs) {
+            _Symbols[_Message._Index].location.value = _Blob_off + _Message._Offset;
         }
 
         return true;
     }
 
     bool _Section_writer::_Write_blob() noexcept {
-        for (const _Writable_message& _Message : _Mymsgs) {
-            if (!_Myfile._Write_message_value(_Message._Value)) { // failed to write blob entry, break
+        if (!_Align_section()) { // failed to align blob, break
+            return false;
+        }
+
+        for (const byte_string_view _Value : _Myblob) {
+            if (!_Myfile._Write_message_value(_Value)) { // failed to write blob entry, break
                 return false;
             }
         }
@@ -226,10 +752,70 @@ namespace mjx {
         return true;
     }
 
-    void _Allocate_symbols_and_copy_ids(vector<symbol>& _Symbols, const vector<message>& _Messages) {
-        _Symbols.reserve(_Messages.size());
-        for (const message& _Message : _Messages) {
-            _Symbols.push_back(symbol{symbol_location{}, _Message.id}); // location isn't known yet
+    utf8_string _Make_qualified_id(const parse_tree& _Tree, const message& _Message) {
+        // join the group's qualified name and message's ID
+        const utf8_string_view _Prefix = _Tree.groups[_Message.group].name;
+        utf8_string _Id;
+        _Id.reserve(_Prefix.size() + _Message.id.size());
+        _Id.append(_Prefix);
+        _Id.append(_Message.id);
+        return _Id;
+    }
+
+    bool _Detect_hash_collisions(const parse_tree& _Tree, report_counters& _Counters) {
+        // Note: The messages are identified only by the hashes of their qualified IDs. The parser checks
+        //       the IDs only within their own groups, so the same qualified ID may still be defined twice
+        //       (e.g. '#x' in the root group and in its group named ""). Equal hashes are therefore
+        //       a collision only if the qualified IDs differ. The hashes are inserted into an open-addressing
+        //       set with the load factor at most 50%, so that the check stays linear.
+        struct _Slot {
+            uint64_t _Hash  = 0;
+            uint32_t _Index = 0; // index of the message + 1, 0 if the slot is empty
+        };
+
+        const arena_vector<message>& _Messages = _Tree.messages;
+        size_t _Size                           = 16;
+        while (_Size < _Messages.size() * 2) {
+            _Size <<= 1;
+        }
+
+        vector<_Slot> _Slots(_Size);
+        const size_t _Mask = _Size - 1;
+        bool _Unique       = true;
+        for (size_t _Msg_idx = 0; _Msg_idx < _Messages.size(); ++_Msg_idx) {
+            const uint64_t _Hash = _Messages[_Msg_idx].hash;
+            for (size_t _Idx = static_cast<size_t>(_Hash) & _Mask;; _Idx = (_Idx + 1) & _Mask) {
+                _Slot& _Current = _Slots[_Idx];
+                if (_Current._Index == 0) { // empty slot found, the hash is unique
+                    _Current._Hash  = _Hash;
+                    _Current._Index = static_cast<uint32_t>(_Msg_idx) + 1;
+                    break;
+                }
+
+                if (_Current._Hash == _Hash) { // same hash found, report an error
+                    const utf8_string _First_id  = _Make_qualified_id(_Tree, _Messages[_Current._Index - 1]);
+                    const utf8_string _Second_id = _Make_qualified_id(_Tree, _Messages[_Msg_idx]);
+                    _Unique                      = false;
+                    if (_First_id == _Second_id) { // the same qualified ID, not a collision
+                        _Report_error(_Counters, L"(?, ?): error E3010: ambiguous message ID, '%s' is defined twice",
+                            _Fast_str_cvt<wchar_t>(_Second_id).c_str());
+                    } else { // different qualified IDs
+                        _Report_error(_Counters, L"(?, ?): error E3007: message IDs '%s' and '%s' have the same hash",
+                            _Fast_str_cvt<wchar_t>(_First_id).c_str(), _Fast_str_cvt<wchar_t>(_Second_id).c_str());
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        return _Unique;
+    }
+
+    void _Allocate_symbols_and_copy_ids(vector<symbol>& _Symbols, const parse_tree& _Tree) {
+        _Symbols.reserve(_Tree.messages.size());
+        for (const message& _Message : _Tree.messages) {
+            _Symbols.push_back(symbol{symbol_location{}, _Make_qualified_id(_Tree, _Message)}); // no location yet
         }
     }
 
@@ -238,13 +824,28 @@ namespace mjx {
         bool _Success        = true;
         const float _Elapsed = measure_invoke_duration(
             [&] {
-                const vector<message>& _Messages = _Get_messages_from_content(_Tree.content);
+                const arena_vector<message>& _Messages = _Tree.messages;
 #ifdef _M_X64
-                const uint32_t _Count            = static_cast<uint32_t>(_Messages.size());
+                const uint32_t _Count                  = static_cast<uint32_t>(_Messages.size());
 #else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
-                const uint32_t _Count            = _Messages.size();
+                const uint32_t _Count                  = _Messages.size();
 #endif // _M_X64
-                if (!_File._Write_signature() || !_File._Write_language(_Tree.language)
+                if (!_Detect_hash_collisions(_Tree, _Counters)) { // messages would be indistinguishable, break
+                    _Success = false;
+                    return;
+                }
+
+                const byte_string& _Language = ::mjx::to_byte_string(_Tree.language);
+                _Section_writer _Writer(_File, _Messages);
+                if (!_Writer._Arrange_entries(_Tree)) { // failed to build the perfect hash index, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3006: cannot generate the UMC file perfect hash index");
+                    return;
+                }
+
+                const size_t _Header_size = _Umc_file::_Header_size(_Language);
+                _File._Reserve(_Header_size + _Writer._Section_size(_Header_size));
+                if (!_File._Write_signature(_Writer._Header_flags()) || !_File._Write_language(_Language)
                     || !_File._Write_lcid(_Tree.lcid) || !_File._Write_message_count(_Count)) {
                     // failed to write header, report an error
                     _Success = false;
@@ -252,7 +853,24 @@ namespace mjx {
                     return;
                 }
 
-                _Section_writer _Writer(_File, _Messages);
+                if (!_Writer._Write_perfect_hash_index()) { // failed to write perfect hash index, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3006: cannot generate the UMC file perfect hash index");
+                    return;
+                }
+
+                if (!_Writer._Write_symbol_table()) { // failed to write symbol table, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3008: cannot generate the UMC file symbol table");
+                    return;
+                }
+
+                if (!_Writer._Write_block_index()) { // failed to write block index, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3009: cannot generate the UMC file block index");
+                    return;
+                }
+
                 if (!_Writer._Write_lookup_table()) { // failed to write lookup table, report an error
                     _Success = false;
                     _Report_error(_Counters, L"(?, ?): error E3003: cannot generate the UMC file lookup table");
@@ -262,6 +880,12 @@ namespace mjx {
                 if (!_Writer._Write_blob()) { // failed to write blob, report an error
                     _Success = false;
                     _Report_error(_Counters, L"(?, ?): error E3004: cannot generate the UMC file blob");
+                    return;
+                }
+
+                if (!_File._Commit()) { // failed to write the UMC file, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3005: cannot write the UMC file");
                 }
             }
         );
@@ -279,13 +903,28 @@ namespace mjx {
         bool _Success        = true;
         const float _Elapsed = measure_invoke_duration(
             [&] {
-                const vector<message>& _Messages = _Get_messages_from_content(_Tree.content);
+                const arena_vector<message>& _Messages = _Tree.messages;
 #ifdef _M_X64
-                const uint32_t _Count            = static_cast<uint32_t>(_Messages.size());
+                const uint32_t _Count                  = static_cast<uint32_t>(_Messages.size());
 #else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
-                const uint32_t _Count            = _Messages.size();
+                const uint32_t _Count                  = _Messages.size();
 #endif // _M_X64
-                if (!_File._Write_signature() || !_File._Write_language(_Tree.language)
+                if (!_Detect_hash_collisions(_Tree, _Counters)) { // messages would be indistinguishable, break
+                    _Success = false;
+                    return;
+                }
+
+                const byte_string& _Language = ::mjx::to_byte_string(_Tree.language);
+                _Section_writer _Writer(_File, _Messages);
+                if (!_Writer._Arrange_entries(_Tree)) { // failed to build the perfect hash index, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3006: cannot generate the UMC file perfect hash index");
+                    return;
+                }
+
+                const size_t _Header_size = _Umc_file::_Header_size(_Language);
+                _File._Reserve(_Header_size + _Writer._Section_size(_Header_size));
+                if (!_File._Write_signature(_Writer._Header_flags()) || !_File._Write_language(_Language)
                     || !_File._Write_lcid(_Tree.lcid) || !_File._Write_message_count(_Count)) {
                     // failed to write header, report an error
                     _Success = false;
@@ -293,8 +932,25 @@ namespace mjx {
                     return;
                 }
 
-                _Allocate_symbols_and_copy_ids(_Symbols, _Messages);
-                _Section_writer _Writer(_File, _Messages);
+                if (!_Writer._Write_perfect_hash_index()) { // failed to write perfect hash index, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3006: cannot generate the UMC file perfect hash index");
+                    return;
+                }
+
+                if (!_Writer._Write_symbol_table()) { // failed to write symbol table, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3008: cannot generate the UMC file symbol table");
+                    return;
+                }
+
+                if (!_Writer._Write_block_index()) { // failed to write block index, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3009: cannot generate the UMC file block index");
+                    return;
+                }
+
+                _Allocate_symbols_and_copy_ids(_Symbols, _Tree);
                 if (!_Writer._Write_lookup_table(_Symbols)) { // failed to write lookup table, report an error
                     _Success = false;
                     _Report_error(_Counters, L"(?, ?): error E3003: cannot generate the UMC file lookup table");
@@ -304,6 +960,12 @@ namespace mjx {
                 if (!_Writer._Write_blob()) { // failed to write blob, report an error
                     _Success = false;
                     _Report_error(_Counters, L"(?, ?): error E3004: cannot generate the UMC file blob");
+                    return;
+                }
+
+                if (!_File._Commit()) { // failed to write the UMC file, report an error
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E3005: cannot write the UMC file");
                 }
             }
         );
@@ -323,13 +985,14 @@ namespace mjx {
         bool _Success              = true;
         const float _Elapsed       = measure_invoke_duration(
             [&] {
-                const auto& [_Analyzed, _Stream] = analyze_input_file(_Target, _Counters);
+                arena _Arena; // owns the parse tree, released at once when the compilation ends
+                auto [_Analyzed, _Reader, _Input] = analyze_input_file(_Target, _Counters);
                 if (!_Analyzed) { // lexical analysis failed, break
                     _Success = false;
                     return;
                 }
 
-                const auto& [_Parsed, _Tree] = parse_token_stream(_Stream, _Pack, _Counters);
+                const auto& [_Parsed, _Tree] = parse_token_stream(_Reader, _Pack, _Arena, _Counters);
                 if (!_Parsed) { // parse failed, break
                     _Success = false;
                     return;
@@ -341,7 +1004,8 @@ namespace mjx {
                     return;
                 }
 
-                if (program_options::current().generate_symbol_file) { // generate symbols
+                const program_options& _Options = program_options::current();
+                if (_Options.generate_symbol_file || _Options.generate_hash_header) { // generate symbols
                     vector<symbol> _Symbols;
                     if (!_Compile_parse_tree_and_generate_symbols(_File, _Tree, _Symbols, _Counters)) {
                         // failed to compile parse tree and generate symbols, break
@@ -349,7 +1013,13 @@ namespace mjx {
                         return;
                     }
 
-                    if (!generate_symbol_file(_Pack, _Symbols, _Counters)) { // failed to generate symbol file
+                    if (_Options.generate_symbol_file && !generate_symbol_file(_Pack, _Symbols, _Counters)) {
+                        // failed to generate symbol file
+                        _Success = false;
+                    }
+
+                    if (_Options.generate_hash_header && !generate_hash_header(_Pack, _Tree, _Symbols, _Counters)) {
+                        // failed to generate header file
                         _Success = false;
                     }
                 } else { // don't generate symbols
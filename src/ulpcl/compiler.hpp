@@ -11,24 +11,16 @@
 #include <mjfs/path.hpp>
 #include <mjstr/string.hpp>
 #include <mjstr/string_view.hpp>
+#include <ulpcl/fsst.hpp>
+#include <ulpcl/hash_header.hpp>
+#include <ulpcl/lz_codec.hpp>
 #include <ulpcl/parser.hpp>
+#include <ulpcl/perfect_hash.hpp>
 #include <ulpcl/symbol_file.hpp>
+#include <ulpcl/umc_format.hpp>
 
 namespace mjx {
     path _Get_output_file_path(const unicode_string_view _Pack);
-    vector<message> _Get_messages_from_group(const group& _Group, const utf8_string& _Namespace);
-    vector<message> _Get_messages_from_content(const root_group& _Content);
-    uint64_t _Compute_hash(const utf8_string_view _Id) noexcept;
-
-#pragma pack(push)
-#pragma pack(4) // align structure members on 4-byte boundaries to avoid alignment issues
-                // while copying raw data
-    struct _Lookup_table_entry {
-        uint64_t _Hash   = 0;
-        uint64_t _Offset = 0;
-        uint32_t _Length = 0;
-    };
-#pragma pack(pop)
 
     class _Umc_file { // UFUI Message Catalog (UMC) file writer
     public:
@@ -42,14 +34,20 @@ namespace mjx {
         // checks if the UMC file is open
         bool _Is_open() const noexcept;
 
+        // returns the size of the header with the specified language name
+        static size_t _Header_size(const byte_string_view _Language) noexcept;
+
+        // reserves space for the whole file image, must be called before anything is written
+        void _Reserve(const size_t _Size);
+
         // returns the current offset
         uint64_t _Current_offset() const noexcept;
 
-        // writes the signature to the UMC file
-        bool _Write_signature() noexcept;
+        // writes the signature with the specified flags to the UMC file
+        bool _Write_signature(const byte_t _Flags) noexcept;
 
         // writes a language name to the UMC file
-        bool _Write_language(const unicode_string_view _Language);
+        bool _Write_language(const byte_string_view _Language) noexcept;
 
         // writes an LCID to the UMC file
         bool _Write_lcid(const uint32_t _Lcid) noexcept;
@@ -57,12 +55,42 @@ namespace mjx {
         // writes a number of messages to the UMC file
         bool _Write_message_count(const uint32_t _Count) noexcept;
 
+        // pads the UMC file with zeros up to the section alignment
+        bool _Align_section() noexcept;
+
+        // writes a perfect hash index to the UMC file
+        bool _Write_perfect_hash_index(const uint64_t _Seed, const vector<uint32_t>& _Pilots) noexcept;
+
+        // writes an FSST symbol table to the UMC file
+        bool _Write_symbol_table(const fsst_table& _Table) noexcept;
+
+        // writes a block index to the UMC file
+        bool _Write_block_index(const vector<_Block_index_entry>& _Blocks) noexcept;
+
+        // writes a number of ordinals to the UMC file
+        bool _Write_ordinal_count(const uint32_t _Count) noexcept;
+
         // writes a lookup table entry to the UMC file
         bool _Write_lookup_table_entry(const _Lookup_table_entry _Entry) noexcept;
 
+        // writes a lookup table entry that describes a compressed value to the UMC file
+        bool _Write_lookup_table_entry(const _Compressed_lookup_table_entry _Entry) noexcept;
+
+        // writes a message's hash to the UMC file
+        bool _Write_hash(const uint64_t _Hash) noexcept;
+
+        // writes a value location to the UMC file
+        bool _Write_value_location(const _Value_location _Location) noexcept;
+
+        // writes a compressed value location to the UMC file
+        bool _Write_value_location(const _Compressed_value_location _Location) noexcept;
+
         // writes a message's value to the UMC file
         bool _Write_message_value(const byte_string_view _Value) noexcept;
 
+        // writes the whole file image to the UMC file at once
+        bool _Commit() noexcept;
+
     private:
         // creates a new UMC file
         void _Create(const path& _Target);
@@ -70,20 +98,46 @@ namespace mjx {
         // opens an existing UMC file
         void _Open(const path& _Target);
 
+        // appends raw bytes to the file image
+        bool _Append(const void* const _Data, const size_t _Size) noexcept;
+
+        // Note: The UMC file is serialized into a single buffer, whose size is computed up front
+        //       from the known lengths of all sections. The buffer is written at once by _Commit(),
+        //       so that a pack with many messages does not require many small writes.
         file _Myfile;
         file_stream _Mystream;
         report_counters& _Myctrs;
+        byte_string _Mybuf; // the file image
+        size_t _Mysize; // the reserved size of the file image
     };
 
-    class _Section_writer { // writes lookup table and blob to the UMC file
+    class _Section_writer { // writes optional indexes and tables, lookup table and blob to the UMC file
     public:
-        _Section_writer(_Umc_file& _File, const vector<message>& _Messages);
+        _Section_writer(_Umc_file& _File, const arena_vector<message>& _Messages);
         ~_Section_writer() noexcept;
 
         _Section_writer()                                  = delete;
         _Section_writer(const _Section_writer&)            = delete;
         _Section_writer& operator=(const _Section_writer&) = delete;
 
+        // arranges lookup table entries and blob according to the program options
+        bool _Arrange_entries(const parse_tree& _Tree);
+
+        // returns the total size of all sections but the header, assuming they start at the specified offset
+        size_t _Section_size(const uint64_t _Offset) const noexcept;
+
+        // returns the UMC file flags that describe the sections layout
+        byte_t _Header_flags() const noexcept;
+
+        // writes perfect hash index to the UMC file (if requested)
+        bool _Write_perfect_hash_index() noexcept;
+
+        // writes symbol table to the UMC file (if the values are compressed)
+        bool _Write_symbol_table() noexcept;
+
+        // writes block index to the UMC file (if the blob is split into compressed blocks)
+        bool _Write_block_index() noexcept;
+
         // writes lookup table to the UMC file
         bool _Write_lookup_table() noexcept;
 
@@ -95,18 +149,72 @@ namespace mjx {
 
     private:
         struct _Writable_message {
-            uint64_t _Hash = 0; // 8-byte hash of the message ID
-            byte_string _Value; // message's value in UTF-8 encoding
+            uint64_t _Hash    = 0; // 8-byte hash of the message ID
+            byte_string_view _Value; // message's value in UTF-8 encoding, owned by the parse tree
+            uint32_t _Index   = 0; // index of the message in the parse tree
+            uint64_t _Offset  = 0; // offset of the value in the blob, shared by equal values
+            uint32_t _Length  = 0; // length of the value in the blob, differs from the value's if compressed
+            uint32_t _Ordinal = 0; // ordinal of the message ID, used only if the values are indexed by ordinals
         };
 
         // converts plain messages to writable
-        vector<_Writable_message> _Convert_messages(const vector<message>& _Messages);
+        vector<_Writable_message> _Convert_messages(const arena_vector<message>& _Messages);
+
+        // sorts writable messages by hashes
+        void _Sort_messages() noexcept;
+
+        // orders writable messages by their positions in the perfect hash index
+        bool _Index_messages();
+
+        // orders writable messages by the ordinals of their IDs, assigned by the global ID map
+        void _Order_messages(const parse_tree& _Tree);
+
+        // stores each distinct value in the blob once and assigns the offsets to the messages
+        void _Pool_values();
+
+        // finds the values that can be stored as the tails of other values
+        static void _Merge_tails(const vector<byte_string_view>& _Values, vector<uint32_t>& _Hosts);
+
+        // stores the distinct values in the blob as they are
+        void _Store_values(const vector<byte_string_view>& _Values, vector<uint64_t>& _Offsets);
+
+        // compresses the distinct values and stores them in the blob
+        void _Compress_values(
+            const vector<byte_string_view>& _Values, vector<uint64_t>& _Offsets, vector<uint32_t>& _Lengths);
+
+        // compresses the blob in blocks
+        void _Compress_blocks();
+
+        // pads the UMC file up to the next section (if the sections are aligned)
+        bool _Align_section() noexcept;
+
+        // writes a lookup table entry in the format determined by the flags
+        bool _Write_entry(const _Writable_message& _Message) noexcept;
+
+        // writes a value location in the format determined by the flags
+        bool _Write_location(const _Writable_message& _Message) noexcept;
+
+        // writes value locations of all messages as a separate section
+        bool _Write_locations() noexcept;
+
+        // writes value locations indexed by ordinals, optionally captures symbols location
+        bool _Write_ordinal_table(vector<symbol>* const _Symbols) noexcept;
 
         _Umc_file& _Myfile;
-        vector<_Writable_message> _Mymsgs;
+        vector<_Writable_message> _Mymsgs; // messages in the lookup table order
+        vector<byte_string_view> _Myblob; // values stored in the blob
+        size_t _Myblob_size;
+        byte_t _Myflags; // describes the sections layout
+        perfect_hash _Myindex;
+        fsst_table _Mytable;
+        byte_string _Mycompressed; // the compressed values or blocks, if requested
+        vector<_Block_index_entry> _Myblocks;
+        uint32_t _Myordinals; // the number of ordinals, if the values are indexed by ordinals
     };
 
-    void _Allocate_symbols_and_copy_ids(vector<symbol>& _Symbols, const vector<message>& _Messages);
+    utf8_string _Make_qualified_id(const parse_tree& _Tree, const message& _Message);
+    bool _Detect_hash_collisions(const parse_tree& _Tree, report_counters& _Counters);
+    void _Allocate_symbols_and_copy_ids(vector<symbol>& _Symbols, const parse_tree& _Tree);
     bool _Compile_parse_tree(_Umc_file& _File, const parse_tree& _Tree, report_counters& _Counters);
     bool _Compile_parse_tree_and_generate_symbols(
         _Umc_file& _File, const parse_tree& _Tree, vector<symbol>& _Symbols, report_counters& _Counters);
@@ -0,0 +1,254 @@
+// fsst.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <ulpcl/fsst.hpp>
+
+namespace mjx {
+    fsst_table::fsst_table() noexcept : _Mysymbols(), _Myorder(), _Mystarts{0} {}
+
+    fsst_table::fsst_table(fsst_table&& _Other) noexcept
+        : _Mysymbols(::std::move(_Other._Mysymbols)), _Myorder(::std::move(_Other._Myorder)), _Mystarts{0} {
+        ::memcpy(_Mystarts, _Other._Mystarts, sizeof(_Mystarts));
+        ::memset(_Other._Mystarts, 0, sizeof(_Other._Mystarts));
+    }
+
+    fsst_table::~fsst_table() noexcept {}
+
+    fsst_table& fsst_table::operator=(fsst_table&& _Other) noexcept {
+        if (this != ::std::addressof(_Other)) {
+            _Mysymbols = ::std::move(_Other._Mysymbols);
+            _Myorder   = ::std::move(_Other._Myorder);
+            ::memcpy(_Mystarts, _Other._Mystarts, sizeof(_Mystarts));
+            ::memset(_Other._Mystarts, 0, sizeof(_Other._Mystarts));
+        }
+
+        return *this;
+    }
+
+    void fsst_table::_Build_index() {
+        _Myorder.resize(_Mysymbols.size());
+        for (size_t _Code = 0; _Code < _Mysymbols.size(); ++_Code) {
+            _Myorder[_Code] = static_cast<byte_t>(_Code);
+        }
+
+        ::std::sort(_Myorder.begin(), _Myorder.end(),
+            [this](const byte_t _Left, const byte_t _Right) noexcept {
+                const _Symbol& _Left_sym  = _Mysymbols[_Left];
+                const _Symbol& _Right_sym = _Mysymbols[_Right];
+                if (_Left_sym._Bytes[0] != _Right_sym._Bytes[0]) {
+                    return _Left_sym._Bytes[0] < _Right_sym._Bytes[0];
+                }
+
+                return _Left_sym._Length != _Right_sym._Length ? _Left_sym._Length > _Right_sym._Length
+                                                               : _Left < _Right;
+            }
+        );
+
+        size_t _Code = 0;
+        for (size_t _Byte = 0; _Byte <= 256; ++_Byte) {
+            while (_Code < _Myorder.size() && _Mysymbols[_Myorder[_Code]]._Bytes[0] < _Byte) {
+                ++_Code;
+            }
+
+            _Mystarts[_Byte] = static_cast<uint16_t>(_Code);
+        }
+    }
+
+    byte_t fsst_table::_Match(const byte_t* const _First, const size_t _Size) const noexcept {
+        const size_t _Last = _Mystarts[static_cast<size_t>(*_First) + 1];
+        for (size_t _Idx = _Mystarts[*_First]; _Idx < _Last; ++_Idx) {
+            const _Symbol& _Sym = _Mysymbols[_Myorder[_Idx]];
+            if (_Sym._Length <= _Size && ::memcmp(_Sym._Bytes, _First, _Sym._Length) == 0) { // the longest match
+                return _Myorder[_Idx];
+            }
+        }
+
+        return escape_code;
+    }
+
+    void fsst_table::train(const vector<byte_string_view>& _Sample) {
+        // Note: The table is trained as described in the FSST paper. In each round, the sample is compressed
+        //       with the current table, and the symbols, as well as the concatenations of the adjacent
+        //       symbols, are counted. The candidates that save the most bytes make up the next table.
+        //       Escaped bytes are counted as single-byte symbols, so that they can become symbols too.
+        struct _Candidate {
+            uint64_t _Bytes = 0; // little-endian packed symbol bytes
+            size_t _Length  = 0;
+            uint64_t _Gain  = 0;
+        };
+
+        constexpr size_t _Rounds = 5;
+        constexpr size_t _Codes  = 512; // symbols followed by the escaped bytes (256 + byte)
+        const auto _Pack         = [](const byte_t* const _Bytes, const size_t _Length) noexcept {
+            uint64_t _Packed = 0;
+            ::memcpy(&_Packed, _Bytes, _Length);
+            return _Packed;
+        };
+
+        _Mysymbols.clear();
+        _Build_index();
+        vector<uint32_t> _Singles(_Codes);
+        vector<uint32_t> _Pairs(_Codes * _Codes);
+        vector<_Candidate> _Candidates;
+        for (size_t _Round = 0; _Round < _Rounds; ++_Round) {
+            ::std::fill(_Singles.begin(), _Singles.end(), 0);
+            ::std::fill(_Pairs.begin(), _Pairs.end(), 0);
+            for (const byte_string_view _Str : _Sample) {
+                size_t _Prev = _Codes; // no previous code
+                for (size_t _Off = 0; _Off < _Str.size();) {
+                    const byte_t _Code = _Match(_Str.data() + _Off, _Str.size() - _Off);
+                    size_t _Counted;
+                    if (_Code == escape_code) { // count the escaped byte
+                        _Counted = 256 + static_cast<size_t>(_Str[_Off]);
+                        ++_Off;
+                    } else {
+                        _Counted = _Code;
+                        _Off    += _Mysymbols[_Code]._Length;
+                    }
+
+                    ++_Singles[_Counted];
+                    if (_Prev != _Codes) {
+                        ++_Pairs[_Prev * _Codes + _Counted];
+                    }
+
+                    _Prev = _Counted;
+                }
+            }
+
+            const auto _Code_bytes = [this](const size_t _Code, byte_t* const _Bytes) noexcept {
+                if (_Code >= 256) { // escaped byte
+                    _Bytes[0] = static_cast<byte_t>(_Code - 256);
+                    return size_t{1};
+                }
+
+                ::memcpy(_Bytes, _Mysymbols[_Code]._Bytes, _Mysymbols[_Code]._Length);
+                return _Mysymbols[_Code]._Length;
+            };
+
+            _Candidates.clear();
+            byte_t _Bytes[2 * max_symbol_length];
+            for (size_t _Code = 0; _Code < _Codes; ++_Code) {
+                if (_Singles[_Code] == 0) { // unused code, skip it
+                    continue;
+                }
+
+                const size_t _Length = _Code_bytes(_Code, _Bytes);
+                _Candidates.push_back(_Candidate{_Pack(_Bytes, _Length), _Length, _Singles[_Code] * _Length});
+                for (size_t _Next = 0; _Next < _Codes; ++_Next) {
+                    const uint32_t _Count = _Pairs[_Code * _Codes + _Next];
+                    if (_Count == 0) { // the codes are never adjacent, skip them
+                        continue;
+                    }
+
+                    const size_t _Concat_length = (::std::min)(
+                        _Length + _Code_bytes(_Next, _Bytes + _Length), max_symbol_length);
+                    _Candidates.push_back(
+                        _Candidate{_Pack(_Bytes, _Concat_length), _Concat_length, _Count * _Concat_length});
+                }
+            }
+
+            // merge equal candidates, then choose the ones with the highest gains
+            ::std::sort(_Candidates.begin(), _Candidates.end(),
+                [](const _Candidate& _Left, const _Candidate& _Right) noexcept {
+                    return _Left._Length != _Right._Length ? _Left._Length < _Right._Length
+                                                           : _Left._Bytes < _Right._Bytes;
+                }
+            );
+            size_t _Unique = 0;
+            for (size_t _Idx = 0; _Idx < _Candidates.size(); ++_Idx) {
+                if (_Unique > 0 && _Candidates[_Unique - 1]._Length == _Candidates[_Idx]._Length
+                    && _Candidates[_Unique - 1]._Bytes == _Candidates[_Idx]._Bytes) {
+                    _Candidates[_Unique - 1]._Gain += _Candidates[_Idx]._Gain;
+                } else {
+                    _Candidates[_Unique++] = _Candidates[_Idx];
+                }
+            }
+
+            _Candidates.resize(_Unique);
+            ::std::stable_sort(_Candidates.begin(), _Candidates.end(),
+                [](const _Candidate& _Left, const _Candidate& _Right) noexcept {
+                    return _Left._Gain > _Right._Gain;
+                }
+            );
+            _Mysymbols.resize((::std::min)(_Candidates.size(), max_symbols));
+            for (size_t _Code = 0; _Code < _Mysymbols.size(); ++_Code) {
+                _Mysymbols[_Code]._Length = _Candidates[_Code]._Length;
+                ::memcpy(_Mysymbols[_Code]._Bytes, &_Candidates[_Code]._Bytes, max_symbol_length);
+            }
+
+            _Build_index();
+        }
+    }
+
+    bool fsst_table::assign(const vector<byte_string_view>& _Symbols) {
+        if (_Symbols.size() > max_symbols) { // too many symbols, break
+            return false;
+        }
+
+        _Mysymbols.resize(_Symbols.size());
+        for (size_t _Code = 0; _Code < _Symbols.size(); ++_Code) {
+            const byte_string_view _Bytes = _Symbols[_Code];
+            if (_Bytes.empty() || _Bytes.size() > max_symbol_length) { // invalid symbol, break
+                _Mysymbols.clear();
+                _Build_index();
+                return false;
+            }
+
+            _Mysymbols[_Code] = _Symbol{};
+            ::memcpy(_Mysymbols[_Code]._Bytes, _Bytes.data(), _Bytes.size());
+            _Mysymbols[_Code]._Length = _Bytes.size();
+        }
+
+        _Build_index();
+        return true;
+    }
+
+    size_t fsst_table::size() const noexcept {
+        return _Mysymbols.size();
+    }
+
+    byte_string_view fsst_table::symbol(const size_t _Code) const noexcept {
+        return byte_string_view{_Mysymbols[_Code]._Bytes, _Mysymbols[_Code]._Length};
+    }
+
+    void fsst_table::compress(const byte_string_view _Str, byte_string& _Out) const {
+        for (size_t _Off = 0; _Off < _Str.size();) {
+            const byte_t _Code = _Match(_Str.data() + _Off, _Str.size() - _Off);
+            _Out.push_back(_Code);
+            if (_Code == escape_code) { // store the byte as is
+                _Out.push_back(_Str[_Off]);
+                ++_Off;
+            } else {
+                _Off += _Mysymbols[_Code]._Length;
+            }
+        }
+    }
+
+    bool fsst_table::decompress(const byte_string_view _Data, byte_t* const _Out, const size_t _Size) const noexcept {
+        size_t _Written = 0;
+        for (size_t _Off = 0; _Off < _Data.size(); ++_Off) {
+            const byte_t _Code = _Data[_Off];
+            if (_Code == escape_code) { // the next byte is stored as is
+                if (++_Off == _Data.size() || _Written == _Size) { // missing or excess byte, break
+                    return false;
+                }
+
+                _Out[_Written++] = _Data[_Off];
+            } else {
+                if (_Code >= _Mysymbols.size() || _Mysymbols[_Code]._Length > _Size - _Written) { // invalid code
+                    return false;
+                }
+
+                ::memcpy(_Out + _Written, _Mysymbols[_Code]._Bytes, _Mysymbols[_Code]._Length);
+                _Written += _Mysymbols[_Code]._Length;
+            }
+        }
+
+        return _Written == _Size;
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,64 @@
+// fsst.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_FSST_HPP_
+#define _ULPCL_FSST_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <ulpcl/utils.hpp>
+
+namespace mjx {
+    class fsst_table { // Fast Static Symbol Table, compresses short strings independently of each other
+    public:
+        static constexpr size_t max_symbols       = 255;
+        static constexpr size_t max_symbol_length = 8;
+        static constexpr byte_t escape_code       = 255; // the next byte is stored as is
+
+        fsst_table() noexcept;
+        fsst_table(fsst_table&& _Other) noexcept;
+        ~fsst_table() noexcept;
+
+        fsst_table& operator=(fsst_table&& _Other) noexcept;
+
+        // trains the symbol table over the sample strings
+        void train(const vector<byte_string_view>& _Sample);
+
+        // replaces the symbols with the specified ones, fails if any of them is empty or too long
+        bool assign(const vector<byte_string_view>& _Symbols);
+
+        // returns the number of symbols
+        size_t size() const noexcept;
+
+        // returns the symbol with the specified code
+        byte_string_view symbol(const size_t _Code) const noexcept;
+
+        // appends the compressed string to _Out
+        void compress(const byte_string_view _Str, byte_string& _Out) const;
+
+        // decompresses the string into _Out, fails if it is malformed or its length is not equal to _Size
+        bool decompress(const byte_string_view _Data, byte_t* const _Out, const size_t _Size) const noexcept;
+
+    private:
+        struct _Symbol {
+            byte_t _Bytes[max_symbol_length] = {0};
+            size_t _Length                   = 0;
+        };
+
+        // returns the code of the longest symbol that starts the string, or the escape code
+        byte_t _Match(const byte_t* const _First, const size_t _Size) const noexcept;
+
+        // groups the symbols by their first bytes, the longest symbols first
+        void _Build_index();
+
+        vector<_Symbol> _Mysymbols;
+        vector<byte_t> _Myorder; // symbol codes grouped by their first bytes
+        uint16_t _Mystarts[257]; // the first code in _Myorder for each byte
+    };
+} // namespace mjx
+
+#endif // _ULPCL_FSST_HPP_
\ No newline at end of file
@@ -0,0 +1,256 @@
+// hash_header.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdio>
+#include <mjfs/status.hpp>
+#include <type_traits>
+#include <ulpcl/hash_header.hpp>
+#include <ulpcl/logger.hpp>
+#include <ulpcl/parser.hpp>
+#include <ulpcl/program.hpp>
+#include <ulpcl/runtime.hpp>
+#include <ulpcl/version.hpp>
+#include <xxhash/xxhash.h>
+
+namespace mjx {
+    void _Hash_header_serializer::_Append_name_char(byte_string& _Name, const byte_t _Ch) {
+        // Note: Names that contain a double underscore are reserved for the implementation, so runs
+        //       of underscores are collapsed into one. Names that differ only in such runs may become
+        //       equal, but they are reported by _Detect_name_collisions() like any other collision.
+        if (_Ch == '_' && !_Name.empty() && _Name.back() == '_') { // would form a double underscore, skip it
+            return;
+        }
+
+        _Name.push_back(_Ch);
+    }
+
+    byte_string _Hash_header_serializer::_Serialize_namespace(const unicode_string_view _Pack) {
+        // Note: The pack name may contain any character that is valid in a file name, so every character
+        //       that is not valid in an identifier is replaced with an underscore. The 'pack_' prefix
+        //       ensures that the name never starts with a digit or collides with a keyword.
+        const path& _Stem = path{_Pack}.stem();
+        byte_string _Name = reinterpret_cast<const byte_t*>("pack_");
+        for (const wchar_t _Ch : _Stem.native()) {
+            const bool _Valid = (_Ch >= L'a' && _Ch <= L'z') || (_Ch >= L'A' && _Ch <= L'Z')
+                || (_Ch >= L'0' && _Ch <= L'9') || _Ch == L'_';
+            _Append_name_char(_Name, _Valid ? static_cast<byte_t>(_Ch) : '_');
+        }
+
+        return _Name;
+    }
+
+    byte_string _Hash_header_serializer::_Serialize_name(const utf8_string_view _Id) {
+        // Note: Message IDs and group names consist only of letters, digits, hyphens and underscores,
+        //       so only the hyphens and the separators ('.' and '#') must be replaced. Root messages
+        //       have no group, so their leading separator is skipped.
+        const size_t _Off = !_Id.empty() && _Id[0] == '#' ? 1 : 0;
+        byte_string _Name = reinterpret_cast<const byte_t*>("id_");
+        _Name.reserve(_Name.size() + _Id.size() - _Off);
+        for (size_t _Idx = _Off; _Idx < _Id.size(); ++_Idx) {
+            const char _Ch = _Id[_Idx];
+            _Append_name_char(_Name, _Ch == '-' || _Ch == '.' || _Ch == '#' ? '_' : static_cast<byte_t>(_Ch));
+        }
+
+        return _Name;
+    }
+
+    byte_string _Hash_header_serializer::_Serialize_constant(
+        const byte_string_view _Name, const uint64_t _Hash, const utf8_string_view _Id) {
+        // Note: This function converts the constant into
+        //       'inline constexpr ::std::uint64_t name = 0x0123456789ABCDEF; // id', where the hash is always
+        //       16 digits in length. The buffer holds the part between the name and the ID, its size is
+        //       calculated as 5 (' = 0x') + 16 (hash digits) + 5 ('; // ') + 1 (null-terminator).
+        constexpr byte_t _Prefix[] = "    inline constexpr ::std::uint64_t ";
+        constexpr size_t _Buf_size = 27;
+        char _Buf[_Buf_size]       = {'\0'};
+        ::snprintf(_Buf, _Buf_size, " = 0x%016llX; // ", static_cast<unsigned long long>(_Hash));
+        byte_string _Bytes = _Prefix;
+        _Bytes.reserve(_Bytes.size() + _Name.size() + (_Buf_size - 1) + _Id.size());
+        _Bytes.append(_Name.data(), _Name.size());
+        _Bytes.append(reinterpret_cast<const byte_t*>(_Buf), _Buf_size - 1);
+        _Bytes.append(reinterpret_cast<const byte_t*>(_Id.data()), _Id.size());
+        return _Bytes;
+    }
+
+    _Hash_header_file::_Hash_header_file(const path& _Target, report_counters& _Counters)
+        : _Myfile(), _Mystream(), _Myctrs(_Counters) {
+        if (::mjx::exists(_Target)) { // open an existing file for overwrite
+            _Open(_Target);
+        } else { // create a new file
+            _Create(_Target);
+        }
+    }
+
+    _Hash_header_file::~_Hash_header_file() noexcept {}
+
+    void _Hash_header_file::_Create(const path& _Target) {
+        if (::mjx::create_file(_Target, ::std::addressof(_Myfile))) {
+            _Mystream.bind_file(_Myfile);
+        } else { // report an error
+            _Report_error(_Myctrs, L"(?, ?): error E5000: cannot create the header file '%s'", _Target.c_str());
+        }
+    }
+
+    void _Hash_header_file::_Open(const path& _Target) {
+        if (_Myfile.open(_Target, file_access::write) && _Myfile.resize(0)) {
+            _Mystream.bind_file(_Myfile);
+        } else { // report an error
+            if (_Myfile.is_open()) { // file may have been opened but not resized, close it now
+                _Myfile.close();
+            }
+
+            _Report_error(_Myctrs, L"(?, ?): error E5001: cannot open the header file '%s'", _Target.c_str());
+        }
+    }
+
+    bool _Hash_header_file::_Is_open() const noexcept {
+        return _Mystream.is_open();
+    }
+
+    bool _Hash_header_file::_Write_comment() {
+        if (!_Mystream.is_open()) { // invalid stream, break
+            return false;
+        }
+
+        constexpr char _Fmt[]      = "// generated by ULPCL %s on %s\n\n";
+        constexpr size_t _Buf_size = 128;
+        byte_t _Buf[_Buf_size]     = {'\0'}; // should accommodate every possible comment
+        const int _Written         = ::snprintf(reinterpret_cast<char*>(_Buf), // negative value on error
+            _Buf_size, _Fmt, _ULPCL_VERSION, get_current_date<char>().c_str());
+        return _Written > 0 ? _Mystream.write(_Buf, static_cast<size_t>(_Written)) : false;
+    }
+
+    bool _Hash_header_file::_Write_prologue(const byte_string_view _Namespace) {
+        if (!_Mystream.is_open()) { // invalid stream, break
+            return false;
+        }
+
+        constexpr byte_t _Includes[] = "#pragma once\n#include <cstdint>\n\nnamespace ulp::";
+        constexpr byte_t _Brace[]    = " {\n";
+        byte_string _Bytes           = _Includes;
+        _Bytes.append(_Namespace.data(), _Namespace.size());
+        _Bytes += _Brace;
+        return _Mystream.write(_Bytes);
+    }
+
+    bool _Hash_header_file::_Write_constant(
+        const byte_string_view _Name, const uint64_t _Hash, const utf8_string_view _Id) {
+        if (!_Mystream.is_open()) { // invalid stream, break
+            return false;
+        }
+
+        byte_string _Bytes = _Hash_header_serializer::_Serialize_constant(_Name, _Hash, _Id);
+        _Bytes.push_back('\n');
+        return _Mystream.write(_Bytes);
+    }
+
+    bool _Hash_header_file::_Write_epilogue(const byte_string_view _Namespace) {
+        if (!_Mystream.is_open()) { // invalid stream, break
+            return false;
+        }
+
+        constexpr byte_t _Comment[] = "} // namespace ulp::";
+        byte_string _Bytes          = _Comment;
+        _Bytes.append(_Namespace.data(), _Namespace.size());
+        _Bytes.push_back('\n');
+        return _Mystream.write(_Bytes);
+    }
+
+    path _Get_hash_header_path(const unicode_string_view _Pack) {
+        // make the path to the header file by concatenating the global output directory
+        // and the pack name, then replacing the '.ulp' extension with '.hpp'
+        return path{program_options::current().output_directory / _Pack}.replace_extension(L".hpp");
+    }
+
+    bool _Detect_name_collisions(
+        const vector<symbol>& _Symbols, const vector<byte_string>& _Names, report_counters& _Counters) {
+        // Note: Distinct qualified IDs may map to the same name, e.g. 'outer#msg-id' and 'outer#msg_id'.
+        //       Such messages would be indistinguishable in the header, so they must be reported. The names
+        //       are inserted into an open-addressing set with the load factor at most 50%.
+        struct _Slot {
+            uint64_t _Hash  = 0;
+            uint32_t _Index = 0; // index of the name + 1, 0 if the slot is empty
+        };
+
+        size_t _Size = 16;
+        while (_Size < _Names.size() * 2) {
+            _Size <<= 1;
+        }
+
+        vector<_Slot> _Slots(_Size);
+        const size_t _Mask = _Size - 1;
+        bool _Unique       = true;
+        for (size_t _Name_idx = 0; _Name_idx < _Names.size(); ++_Name_idx) {
+            const byte_string& _Name = _Names[_Name_idx];
+            const uint64_t _Hash     = ::XXH3_64bits(_Name.data(), _Name.size());
+            for (size_t _Idx = static_cast<size_t>(_Hash) & _Mask;; _Idx = (_Idx + 1) & _Mask) {
+                _Slot& _Current = _Slots[_Idx];
+                if (_Current._Index == 0) { // empty slot found, the name is unique
+                    _Current._Hash  = _Hash;
+                    _Current._Index = static_cast<uint32_t>(_Name_idx) + 1;
+                    break;
+                }
+
+                if (_Current._Hash == _Hash && _Names[_Current._Index - 1] == _Name) { // same name found
+                    _Unique = false;
+                    _Report_error(_Counters,
+                        L"(?, ?): error E5003: message IDs '%s' and '%s' map to the same constant '%s'",
+                        _Fast_str_cvt<wchar_t>(_Symbols[_Current._Index - 1].id).c_str(),
+                        _Fast_str_cvt<wchar_t>(_Symbols[_Name_idx].id).c_str(),
+                        _Fast_str_cvt<wchar_t>(_Name).c_str());
+                    break;
+                }
+            }
+        }
+
+        return _Unique;
+    }
+
+    bool generate_hash_header(const unicode_string_view _Pack, const parse_tree& _Tree,
+        const vector<symbol>& _Symbols, report_counters& _Counters) {
+        // Note: The symbols are allocated in the order of the messages, so the hash of each symbol ID
+        //       is already stored in the corresponding message and doesn't have to be computed again.
+        vector<byte_string> _Names;
+        _Names.reserve(_Symbols.size());
+        for (const symbol& _Symbol : _Symbols) {
+            _Names.push_back(_Hash_header_serializer::_Serialize_name(_Symbol.id));
+        }
+
+        if (!_Detect_name_collisions(_Symbols, _Names, _Counters)) { // constants would be ambiguous, break
+            return false;
+        }
+
+        const path& _Path = _Get_hash_header_path(_Pack);
+        _Hash_header_file _File(_Path, _Counters);
+        if (!_File._Is_open()) { // failed to open/create the header file, break
+            return false;
+        }
+
+        if (!_File._Write_comment()) { // failed to write the comment, report a warning
+            _Report_warning(_Counters,
+                L"(?, ?): warning W5000: cannot write comment to the header file '%s'", _Path.c_str());
+        }
+
+        const byte_string& _Namespace = _Hash_header_serializer::_Serialize_namespace(_Pack);
+        if (!_File._Write_prologue(_Namespace)) {
+            _Report_error(_Counters, L"(?, ?): error E5002: cannot write to the header file '%s'", _Path.c_str());
+            return false;
+        }
+
+        for (size_t _Idx = 0; _Idx < _Symbols.size(); ++_Idx) {
+            if (!_File._Write_constant(_Names[_Idx], _Tree.messages[_Idx].hash, _Symbols[_Idx].id)) {
+                _Report_error(_Counters, L"(?, ?): error E5002: cannot write to the header file '%s'", _Path.c_str());
+                return false;
+            }
+        }
+
+        if (!_File._Write_epilogue(_Namespace)) {
+            _Report_error(_Counters, L"(?, ?): error E5002: cannot write to the header file '%s'", _Path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+} // namespace mjx
\ No newline at end of file
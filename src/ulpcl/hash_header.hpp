@@ -0,0 +1,81 @@
+// hash_header.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_HASH_HEADER_HPP_
+#define _ULPCL_HASH_HEADER_HPP_
+#include <cstdint>
+#include <mjfs/file.hpp>
+#include <mjfs/file_stream.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <ulpcl/symbol_file.hpp>
+#include <ulpcl/utils.hpp>
+
+namespace mjx {
+    struct _Hash_header_serializer {
+        // appends the character to the name, unless it would form a double underscore
+        static void _Append_name_char(byte_string& _Name, const byte_t _Ch);
+
+        // converts the pack name into the name of the namespace, e.g. 'Polski.ulp' into 'pack_Polski'
+        static byte_string _Serialize_namespace(const unicode_string_view _Pack);
+
+        // converts the qualified ID into the name of the constant, e.g. 'outer#msg-id' into 'id_outer_msg_id'
+        static byte_string _Serialize_name(const utf8_string_view _Id);
+
+        // converts the constant into a string
+        static byte_string _Serialize_constant(
+            const byte_string_view _Name, const uint64_t _Hash, const utf8_string_view _Id);
+    };
+
+    struct parse_tree;
+    struct report_counters;
+
+    class _Hash_header_file {
+    public:
+        _Hash_header_file(const path& _Target, report_counters& _Counters);
+        ~_Hash_header_file() noexcept;
+
+        _Hash_header_file(const _Hash_header_file&)            = delete;
+        _Hash_header_file& operator=(const _Hash_header_file&) = delete;
+
+        // checks if the header file is open
+        bool _Is_open() const noexcept;
+
+        // writes automatically-generated comment to the header file
+        bool _Write_comment();
+
+        // writes the include directives and opens the namespace
+        bool _Write_prologue(const byte_string_view _Namespace);
+
+        // writes a constant to the header file
+        bool _Write_constant(const byte_string_view _Name, const uint64_t _Hash, const utf8_string_view _Id);
+
+        // closes the namespace
+        bool _Write_epilogue(const byte_string_view _Namespace);
+
+    private:
+        // creates a new header file
+        void _Create(const path& _Target);
+
+        // opens an existing header file
+        void _Open(const path& _Target);
+
+        file _Myfile;
+        file_stream _Mystream;
+        report_counters& _Myctrs;
+    };
+
+    path _Get_hash_header_path(const unicode_string_view _Pack);
+
+    // checks if every message maps to a distinct constant name
+    bool _Detect_name_collisions(
+        const vector<symbol>& _Symbols, const vector<byte_string>& _Names, report_counters& _Counters);
+
+    bool generate_hash_header(const unicode_string_view _Pack, const parse_tree& _Tree,
+        const vector<symbol>& _Symbols, report_counters& _Counters);
+} // namespace mjx
+
+#endif // _ULPCL_HASH_HEADER_HPP_
\ No newline at end of file
@@ -0,0 +1,354 @@
+// id_map.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdio>
+#include <mjfs/file.hpp>
+#include <mjfs/file_stream.hpp>
+#include <mjfs/status.hpp>
+#include <mjsync/async.hpp>
+#include <mjsync/thread_pool.hpp>
+#include <type_traits>
+#include <ulpcl/arena.hpp>
+#include <ulpcl/compiler.hpp>
+#include <ulpcl/id_map.hpp>
+#include <ulpcl/lexer.hpp>
+#include <ulpcl/logger.hpp>
+#include <ulpcl/mapped_file.hpp>
+#include <ulpcl/parser.hpp>
+#include <ulpcl/program.hpp>
+#include <ulpcl/runtime.hpp>
+#include <ulpcl/version.hpp>
+#include <xxhash/xxhash.h>
+
+namespace mjx {
+    id_map::id_map() noexcept : _Myentries(), _Myslots(), _Mylock() {}
+
+    id_map::~id_map() noexcept {}
+
+    id_map& id_map::current() noexcept {
+        static id_map _Map;
+        return _Map;
+    }
+
+    uint32_t id_map::size() const noexcept {
+#ifdef _M_X64
+        return static_cast<uint32_t>(_Myentries.size());
+#else // ^^^ _M_X64 ^^^ / vvv _M_IX86 vvv
+        return _Myentries.size();
+#endif // _M_X64
+    }
+
+    void id_map::_Rehash(const size_t _Count) {
+        size_t _Size = 16;
+        while (_Size < _Count * 2) {
+            _Size <<= 1;
+        }
+
+        _Myslots.assign(_Size, _Slot{});
+        const size_t _Mask = _Size - 1;
+        for (size_t _Entry_idx = 0; _Entry_idx < _Myentries.size(); ++_Entry_idx) {
+            const uint64_t _Hash = _Myentries[_Entry_idx]._Hash;
+            size_t _Idx          = static_cast<size_t>(_Hash) & _Mask;
+            while (_Myslots[_Idx]._Index != 0) {
+                _Idx = (_Idx + 1) & _Mask;
+            }
+
+            _Myslots[_Idx]._Hash  = _Hash;
+            _Myslots[_Idx]._Index = static_cast<uint32_t>(_Entry_idx) + 1;
+        }
+    }
+
+    uint32_t id_map::_Find_or_insert(const utf8_string_view _Id, const uint64_t _Hash) {
+        if (_Myslots.size() < (_Myentries.size() + 1) * 2) { // keep the load factor at most 50%
+            _Rehash(_Myentries.size() + 1);
+        }
+
+        const size_t _Mask = _Myslots.size() - 1;
+        for (size_t _Idx = static_cast<size_t>(_Hash) & _Mask;; _Idx = (_Idx + 1) & _Mask) {
+            _Slot& _Current = _Myslots[_Idx];
+            if (_Current._Index == 0) { // empty slot found, append a new entry
+                _Myentries.push_back(_Entry{utf8_string{_Id}, _Hash});
+                _Current._Hash  = _Hash;
+                _Current._Index = size();
+                return _Current._Index - 1;
+            }
+
+            if (_Current._Hash == _Hash && _Myentries[_Current._Index - 1]._Id == _Id) { // same ID found
+                return _Current._Index - 1;
+            }
+        }
+    }
+
+    bool id_map::_Parse(const byte_string_view _Data) {
+        // Note: Each line stores an ordinal followed by a colon, a space and the qualified ID. The IDs
+        //       that were removed are prefixed with a tilde. The ordinals must be consecutive, starting
+        //       from zero, comments and empty lines are skipped.
+        const char* _Ptr       = reinterpret_cast<const char*>(_Data.data());
+        const char* const _End = _Ptr + _Data.size();
+        while (_Ptr < _End) {
+            const char* _Line_end = _Ptr;
+            while (_Line_end < _End && *_Line_end != '\n') {
+                ++_Line_end;
+            }
+
+            utf8_string_view _Line{_Ptr, static_cast<size_t>(_Line_end - _Ptr)};
+            _Ptr = _Line_end < _End ? _Line_end + 1 : _End;
+            if (!_Line.empty() && _Line.back() == '\r') { // ignore the carriage return
+                _Line.remove_suffix(1);
+            }
+
+            if (_Line.empty() || _Line.starts_with("//")) { // comment or empty line, skip it
+                continue;
+            }
+
+            uint64_t _Ordinal = 0;
+            size_t _Off       = 0;
+            for (; _Off < _Line.size() && _Line[_Off] >= '0' && _Line[_Off] <= '9'; ++_Off) {
+                _Ordinal = _Ordinal * 10 + static_cast<uint64_t>(_Line[_Off] - '0');
+                if (_Ordinal > UINT32_MAX) { // ordinal too large, break
+                    return false;
+                }
+            }
+
+            if (_Off == 0 || _Ordinal != _Myentries.size() || _Line.size() - _Off < 3
+                || _Line[_Off] != ':' || _Line[_Off + 1] != ' ') { // not the next ordinal, break
+                return false;
+            }
+
+            _Line.remove_prefix(_Off + 2);
+            const bool _Removed = _Line[0] == '~';
+            if (_Removed) { // removed ID
+                _Line.remove_prefix(1);
+            }
+
+            const uint64_t _Hash = ::XXH3_64bits(_Line.data(), _Line.size());
+            if (_Line.empty() || _Find_or_insert(_Line, _Hash) != _Ordinal) { // empty or repeated ID, break
+                return false;
+            }
+
+            _Myentries.back()._Removed = _Removed;
+        }
+
+        return true;
+    }
+
+    bool id_map::load(const path& _Target) {
+        lock_guard _Guard(_Mylock);
+        _Myentries.clear();
+        _Myslots.clear();
+        if (!::mjx::exists(_Target)) { // no ID map yet, start with an empty one
+            return true;
+        }
+
+        file _File(_Target, file_access::read, file_share::read);
+        if (!_File.is_open()) { // failed to open the ID map file, break
+            return false;
+        }
+
+        const mapped_file _Mapped(_File);
+        if (!_Mapped.is_open()) { // empty or unreadable ID map file
+            return _File.size() == 0;
+        }
+
+        if (!_Parse(_Mapped.view())) { // malformed ID map file, start over with an empty map
+            _Myentries.clear();
+            _Myslots.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool id_map::_Write_file(const path& _Target, const byte_string_view _Bytes) {
+        file _File;
+        if (::mjx::exists(_Target)) { // open an existing file for overwrite
+            if (!_File.open(_Target, file_access::write) || !_File.resize(0)) {
+                return false;
+            }
+        } else if (!::mjx::create_file(_Target, ::std::addressof(_File))) { // failed to create a new file
+            return false;
+        }
+
+        // make sure that the whole map reached the file before it replaces the previous one
+        file_stream _Stream(_File);
+        return _Stream.write(_Bytes) && _Stream.flush() && _File.size() == _Bytes.size();
+    }
+
+    bool id_map::save(const path& _Target, const bool _Remove_unused) {
+        lock_guard _Guard(_Mylock);
+        constexpr char _Fmt[]      = "// generated by ULPCL %s on %s\n\n";
+        constexpr size_t _Buf_size = 128;
+        char _Buf[_Buf_size]       = {'\0'}; // should accommodate every comment and ordinal
+        int _Written               = ::snprintf(_Buf, _Buf_size, _Fmt, // negative value on error
+            _ULPCL_VERSION, get_current_date<char>().c_str());
+        if (_Written <= 0) { // failed to format the comment, break
+            return false;
+        }
+
+        byte_string _Bytes{reinterpret_cast<const byte_t*>(_Buf), static_cast<size_t>(_Written)};
+        for (size_t _Ordinal = 0; _Ordinal < _Myentries.size(); ++_Ordinal) {
+            _Entry& _Current = _Myentries[_Ordinal];
+            if (_Current._Used) { // used by some pack, restore it if it was removed before
+                _Current._Removed = false;
+            } else if (_Remove_unused) { // not used by any pack, keep its ordinal reserved
+                _Current._Removed = true;
+            }
+
+            _Written = ::snprintf(_Buf, _Buf_size, _Current._Removed ? "%zu: ~" : "%zu: ", _Ordinal);
+            _Bytes.append(reinterpret_cast<const byte_t*>(_Buf), static_cast<size_t>(_Written));
+            _Bytes.append(reinterpret_cast<const byte_t*>(_Current._Id.data()), _Current._Id.size());
+            _Bytes.push_back('\n');
+        }
+
+        // Note: The map is written to a temporary file that replaces the ID map file only once it is complete,
+        //       so that a failed or interrupted write never leaves a truncated map behind, which would fail
+        //       to load and make every later build abort.
+        path _Temp = _Target;
+        _Temp     += L".tmp";
+        if (!_Write_file(_Temp, _Bytes)) { // failed to write the temporary file, remove it
+            ::mjx::delete_file(_Temp);
+            return false;
+        }
+
+        if (!::mjx::rename(_Temp, _Target)) { // failed to replace the ID map file, remove the temporary file
+            ::mjx::delete_file(_Temp);
+            return false;
+        }
+
+        return true;
+    }
+
+    void id_map::insert(const vector<qualified_id>& _Ids) {
+        lock_guard _Guard(_Mylock);
+        for (const qualified_id& _Id : _Ids) {
+            (void) _Find_or_insert(_Id.id, _Id.hash);
+        }
+    }
+
+    uint32_t id_map::assign(const parse_tree& _Tree, vector<uint32_t>& _Ordinals) {
+        // Note: The qualified IDs are made before the lock is acquired, so that the packs compiled
+        //       on other threads wait only for the map to be searched.
+        const arena_vector<message>& _Messages = _Tree.messages;
+        vector<utf8_string> _Ids;
+        _Ids.reserve(_Messages.size());
+        for (const message& _Message : _Messages) {
+            _Ids.push_back(_Make_qualified_id(_Tree, _Message));
+        }
+
+        lock_guard _Guard(_Mylock);
+        _Ordinals.resize(_Messages.size());
+        for (size_t _Idx = 0; _Idx < _Messages.size(); ++_Idx) {
+            _Ordinals[_Idx]                    = _Find_or_insert(_Ids[_Idx], _Messages[_Idx].hash);
+            _Myentries[_Ordinals[_Idx]]._Used = true;
+        }
+
+        return size();
+    }
+
+    path _Get_id_map_path() {
+        // the ID map is shared by all packs, so it is stored directly in the global output directory
+        return program_options::current().output_directory / L"ids.idm";
+    }
+
+    bool load_id_map() {
+        if (!program_options::current().ordinal_ids) { // ordinal IDs not requested, do nothing
+            return true;
+        }
+
+        const path& _Path = _Get_id_map_path();
+        if (!id_map::current().load(_Path)) { // the ordinals would not be stable, report an error
+            rtlog(L"Error: Cannot load the ID map file '%s'", _Path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    void _Collect_qualified_ids(const path& _Target, vector<qualified_id>& _Ids) noexcept {
+        // the pack is compiled later, so its messages are reported only once, during the compilation
+        compilation_log_mute _Mute;
+        try {
+            report_counters _Counters;
+            arena _Arena; // owns the parse tree, released at once when the IDs are collected
+            auto [_Analyzed, _Reader, _Input] = analyze_input_file(_Target, _Counters);
+            if (!_Analyzed) { // lexical analysis failed, the compilation will fail as well
+                return;
+            }
+
+            const auto& [_Parsed, _Tree] = parse_token_stream(
+                _Reader, _Target.filename().native(), _Arena, _Counters);
+            if (!_Parsed) { // parse failed, the compilation will fail as well
+                return;
+            }
+
+            _Ids.reserve(_Tree.messages.size());
+            for (const message& _Message : _Tree.messages) {
+                _Ids.push_back(qualified_id{_Make_qualified_id(_Tree, _Message), _Message.hash});
+            }
+        } catch (...) { // the compilation will fail the same way and report it, don't append any IDs
+            _Ids.clear();
+        }
+    }
+
+    void extend_id_map() {
+        const program_options& _Options = program_options::current();
+        if (!_Options.ordinal_ids) { // ordinal IDs not requested, do nothing
+            return;
+        }
+
+        // Note: If the packs are compiled on multiple threads, they reach the ID map in an unspecified order.
+        //       To keep the ordinals independent of the scheduling, the IDs of all packs are collected before
+        //       any pack is compiled, and the new ones are appended in the order of the input files. This
+        //       costs an additional parse of each pack, which is done in parallel if possible.
+        const vector<path>& _Files = _Options.input_files;
+        vector<vector<qualified_id>> _Packs(_Files.size());
+        if (_Options.threads > 1 && _Files.size() > 1) { // collect the IDs on the thread-pool's threads
+            thread_pool _Pool(_Options.threads);
+            vector<task> _Tasks;
+            _Tasks.reserve(_Files.size());
+            for (size_t _Idx = 0; _Idx < _Files.size(); ++_Idx) {
+                task _Task = ::mjx::async(_Pool,
+                    [&_Target = _Files[_Idx], &_Ids = _Packs[_Idx]] {
+                        _Collect_qualified_ids(_Target, _Ids);
+                    }
+                );
+                if (_Task.is_registered()) { // the IDs will be collected on the thread-pool's thread
+                    _Tasks.push_back(::std::move(_Task));
+                } else { // failed to schedule the task, collect the IDs on this thread
+                    _Collect_qualified_ids(_Files[_Idx], _Packs[_Idx]);
+                }
+            }
+
+            for (task& _Task : _Tasks) {
+                _Task.wait_until_done();
+            }
+        } else { // collect the IDs on this thread
+            for (size_t _Idx = 0; _Idx < _Files.size(); ++_Idx) {
+                _Collect_qualified_ids(_Files[_Idx], _Packs[_Idx]);
+            }
+        }
+
+        id_map& _Map = id_map::current();
+        for (const vector<qualified_id>& _Ids : _Packs) {
+            _Map.insert(_Ids);
+        }
+    }
+
+    bool save_id_map(const bool _Build_succeeded) {
+        if (!program_options::current().ordinal_ids) { // ordinal IDs not requested, do nothing
+            return true;
+        }
+
+        // remove the unused IDs only if every pack was compiled, otherwise the IDs of the packs
+        // that failed would be removed as well
+        const path& _Path = _Get_id_map_path();
+        if (!id_map::current().save(_Path, _Build_succeeded)) { // failed to save the ID map, report an error
+            rtlog(L"Error: Cannot save the ID map file '%s'", _Path.c_str());
+            return false;
+        }
+
+        return true;
+    }
+} // namespace mjx
\ No newline at end of file
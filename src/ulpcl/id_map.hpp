@@ -0,0 +1,95 @@
+// id_map.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_ID_MAP_HPP_
+#define _ULPCL_ID_MAP_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/path.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <mjsync/srwlock.hpp>
+#include <ulpcl/utils.hpp>
+
+namespace mjx {
+    struct parse_tree;
+
+    struct qualified_id {
+        utf8_string id;
+        uint64_t hash = 0; // hash of the qualified ID, same as the hash of the message
+    };
+
+    class id_map { // assigns dense ordinals to qualified message IDs, shared by all packs
+    public:
+        id_map() noexcept;
+        ~id_map() noexcept;
+
+        id_map(const id_map&)            = delete;
+        id_map& operator=(const id_map&) = delete;
+
+        // returns the global instance of the ID map
+        static id_map& current() noexcept;
+
+        // returns the number of ordinals, including the removed ones
+        uint32_t size() const noexcept;
+
+        // loads the ID map file, the map stays empty if the file doesn't exist yet
+        bool load(const path& _Target);
+
+        // saves the ID map file, optionally removes the IDs that were not used by any pack
+        bool save(const path& _Target, const bool _Remove_unused);
+
+        // appends the IDs that are not in the map yet, in the specified order
+        void insert(const vector<qualified_id>& _Ids);
+
+        // assigns ordinals to the messages, the IDs that are not in the map yet are appended to it
+        uint32_t assign(const parse_tree& _Tree, vector<uint32_t>& _Ordinals);
+
+    private:
+        struct _Entry {
+            utf8_string _Id;
+            uint64_t _Hash = 0; // hash of the qualified ID, same as the hash of the message
+            bool _Removed  = false; // the ID was not used by any pack, its ordinal is never reused
+            bool _Used     = false; // the ID was used by some pack during this build
+        };
+
+        struct _Slot {
+            uint64_t _Hash  = 0;
+            uint32_t _Index = 0; // index of the entry + 1, 0 if the slot is empty
+        };
+
+        // parses the ID map file contents, fails if they are malformed
+        bool _Parse(const byte_string_view _Data);
+
+        // returns the index of the entry with the specified ID, or appends a new one
+        uint32_t _Find_or_insert(const utf8_string_view _Id, const uint64_t _Hash);
+
+        // rebuilds the slots so that they can hold the specified number of entries with the load factor at most 50%
+        void _Rehash(const size_t _Count);
+
+        // writes the bytes to the specified file, fails if they were not written entirely
+        static bool _Write_file(const path& _Target, const byte_string_view _Bytes);
+
+        // Note: The packs may be compiled on multiple threads, so the entries are modified only while
+        //       holding the lock. The entries are never removed, so the ordinals remain dense and stable.
+        vector<_Entry> _Myentries; // entries in the ordinal order
+        vector<_Slot> _Myslots;
+        shared_lock _Mylock;
+    };
+
+    path _Get_id_map_path();
+
+    // loads the global ID map before the build (if ordinal IDs are requested)
+    bool load_id_map();
+
+    // appends the new IDs of all input files to the global ID map (if ordinal IDs are requested)
+    void extend_id_map();
+
+    // saves the global ID map after the build (if ordinal IDs are requested)
+    bool save_id_map(const bool _Build_succeeded);
+} // namespace mjx
+
+#endif // _ULPCL_ID_MAP_HPP_
\ No newline at end of file
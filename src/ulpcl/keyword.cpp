@@ -3,26 +3,72 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <cstddef>
+#include <mjstr/char_traits.hpp>
 #include <ulpcl/keyword.hpp>
 
 namespace mjx {
+    struct _Keyword_entry {
+        const char* _Name = nullptr;
+        size_t _Size      = 0;
+        keyword _Value    = keyword::none;
+    };
+
+    constexpr _Keyword_entry _Keywords[] = {
+        {"@language", 9, keyword::language},
+        {"@lcid", 5, keyword::lcid},
+        {"@meta", 5, keyword::meta},
+        {"@content", 8, keyword::content},
+        {"@group", 6, keyword::group}
+    };
+
+    constexpr size_t _Keyword_table_size = 16;
+
+    constexpr size_t _Hash_keyword(const size_t _Size, const unsigned char _Second) noexcept {
+        // Note: Every keyword starts with '@', so the second character and the length are enough
+        //       to distinguish them. The table size is chosen so that no two keywords collide.
+        return (_Size + _Second) & (_Keyword_table_size - 1);
+    }
+
+    struct _Keyword_table {
+        _Keyword_entry _Entries[_Keyword_table_size];
+        bool _Perfect = true; // true if no two keywords share the same slot
+    };
+
+    constexpr _Keyword_table _Make_keyword_table() noexcept {
+        _Keyword_table _Table;
+        for (const _Keyword_entry& _Entry : _Keywords) {
+            _Keyword_entry& _Slot = _Table._Entries[
+                _Hash_keyword(_Entry._Size, static_cast<unsigned char>(_Entry._Name[1]))];
+            if (_Slot._Value != keyword::none) { // collision detected
+                _Table._Perfect = false;
+            }
+
+            _Slot = _Entry;
+        }
+
+        return _Table;
+    }
+
+    constexpr _Keyword_table _Keyword_lookup = _Make_keyword_table();
+    static_assert(_Keyword_lookup._Perfect, "the keyword hash must be perfect");
+
     keyword parse_keyword(const byte_string_view _Keyword) noexcept {
         return parse_keyword(utf8_string_view{reinterpret_cast<const char*>(_Keyword.data()), _Keyword.size()});
     }
 
     keyword parse_keyword(const utf8_string_view _Keyword) noexcept {
-        if (_Keyword == "@language") {
-            return keyword::language;
-        } else if (_Keyword == "@lcid") {
-            return keyword::lcid;
-        } else if (_Keyword == "@meta") {
-            return keyword::meta;
-        } else if (_Keyword == "@content") {
-            return keyword::content;
-        } else if (_Keyword == "@group") {
-            return keyword::group;
-        } else {
+        if (_Keyword.size() < 2 || _Keyword[0] != '@') { // not a keyword
             return keyword::none;
         }
+
+        const _Keyword_entry& _Entry = _Keyword_lookup._Entries[
+            _Hash_keyword(_Keyword.size(), static_cast<unsigned char>(_Keyword[1]))];
+        if (_Entry._Size != _Keyword.size()
+            || !char_traits<char>::eq(_Entry._Name, _Keyword.data(), _Keyword.size())) { // not a keyword
+            return keyword::none;
+        }
+
+        return _Entry._Value;
     }
 } // namespace mjx
\ No newline at end of file
@@ -3,54 +3,215 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
+#include <limits>
 #include <mjfs/file.hpp>
-#include <mjfs/file_stream.hpp>
 #include <mjmem/exception.hpp>
+#include <mjstr/char_traits.hpp>
+#include <mjsync/async.hpp>
+#include <mjsync/thread.hpp>
+#include <mjsync/thread_pool.hpp>
 #include <ulpcl/keyword.hpp>
 #include <ulpcl/lexer.hpp>
 #include <ulpcl/logger.hpp>
+#include <ulpcl/mapped_file.hpp>
 #include <ulpcl/program.hpp>
 #include <ulpcl/runtime.hpp>
+#include <ulpcl/simd.hpp>
 #include <type_traits>
 
 namespace mjx {
     size_t token_stream::size() const noexcept {
-        return _Mytokens.size();
+        return _Mytypes.size();
     }
 
-    const token& token_stream::get_token(const size_t _Idx) const {
-        if (_Idx >= _Mytokens.size()) {
+    token token_stream::get_token(const size_t _Idx) const {
+        if (_Idx >= _Mytypes.size()) {
             resource_overrun::raise();
         }
 
-        return _Mytokens[_Idx];
+        const token_span& _Span = _Myspans[_Idx];
+        return token{_Mypositions[_Idx], _Mytypes[_Idx], _Span.pooled, _Span.offset, _Span.length, _Span.kw};
+    }
+
+    token_type token_stream::get_type(const size_t _Idx) const {
+        if (_Idx >= _Mytypes.size()) {
+            resource_overrun::raise();
+        }
+
+        return _Mytypes[_Idx];
+    }
+
+    byte_string_view token_stream::data(const token& _Token) const noexcept {
+        static constexpr byte_t _Punctuation[] = {'{', '}', ':'};
+        switch (_Token.type) {
+        case token_type::left_curly_bracket:
+            return byte_string_view{_Punctuation, 1};
+        case token_type::right_curly_bracket:
+            return byte_string_view{_Punctuation + 1, 1};
+        case token_type::colon:
+            return byte_string_view{_Punctuation + 2, 1};
+        default:
+            if (_Token.length == 0) { // no data, e.g. an empty string literal
+                return byte_string_view{};
+            }
+
+            const byte_t* const _First = _Token.pooled ? _Mypool.data() : _Myinput.data();
+            return byte_string_view{_First + _Token.offset, _Token.length};
+        }
+    }
+
+    token_location token_stream::locate(const uint32_t _Position) const {
+        if (_Mylines.empty()) { // build the line index on first use
+            const byte_t* const _First = _Myinput.data();
+            const byte_t* const _Last  = _First + _Myinput.size();
+            _Mylines.push_back(0);
+            for (const byte_t* _Eol = _Find_eol(_First, _Last); _Eol != _Last; _Eol = _Find_eol(_Eol + 1, _Last)) {
+                _Mylines.push_back(static_cast<uint32_t>(_Eol - _First) + 1); // the next line starts after EOL
+            }
+        }
+
+        // find the last line that starts at or before _Position, both line and column are one-based
+        const auto _Next     = ::std::upper_bound(_Mylines.begin(), _Mylines.end(), _Position);
+        const uint32_t _Line = static_cast<uint32_t>(_Next - _Mylines.begin());
+        return token_location{_Line, _Position - *(_Next - 1) + 1};
+    }
+
+    bool token_stream::matches(
+        const size_t _Off, const token_type* const _Types, const size_t _Count) const noexcept {
+        if (_Off > _Mytypes.size() || _Mytypes.size() - _Off < _Count) { // not enough tokens
+            return false;
+        }
+
+        static_assert(sizeof(token_type) == 1, "token_type must be a single byte");
+        return char_traits<byte_t>::eq(reinterpret_cast<const byte_t*>(_Mytypes.data() + _Off),
+            reinterpret_cast<const byte_t*>(_Types), _Count);
+    }
+
+    size_t token_stream::count_consecutive(const size_t _Off, const token_type _Type) const noexcept {
+        if (_Off >= _Mytypes.size()) { // no tokens
+            return 0;
+        }
+
+        const byte_t* const _First = reinterpret_cast<const byte_t*>(_Mytypes.data() + _Off);
+        const byte_t* const _Last  = reinterpret_cast<const byte_t*>(_Mytypes.data() + _Mytypes.size());
+        return static_cast<size_t>(_Find_other_byte(_First, _Last, static_cast<byte_t>(_Type)) - _First);
+    }
+
+    byte_string_view token_stream::input() const noexcept {
+        return _Myinput;
+    }
+
+    void token_stream::bind_input(const byte_string_view _Input) noexcept {
+        _Myinput = _Input;
+    }
+
+    uint32_t token_stream::pool(const byte_string_view _Data) {
+        const uint32_t _Off = static_cast<uint32_t>(_Mypool.size());
+        _Mypool.append(_Data);
+        return _Off;
     }
 
     void token_stream::append(const token& _Token) {
-        _Mytokens.push_back(_Token);
+        _Mytypes.push_back(_Token.type);
+        _Myspans.push_back(token_span{_Token.offset, _Token.length, _Token.pooled, _Token.kw});
+        _Mypositions.push_back(_Token.position);
+    }
+
+    void token_stream::append(const token_stream& _Other) {
+        // both streams refer to the same input data, only the offsets of the pooled data must be adjusted
+        const uint32_t _Pool_off = static_cast<uint32_t>(_Mypool.size());
+        _Mypool.append(_Other._Mypool.view());
+        _Mytypes.insert(_Mytypes.end(), _Other._Mytypes.begin(), _Other._Mytypes.end());
+        _Myspans.reserve(_Myspans.size() + _Other._Myspans.size());
+        for (token_span _Span : _Other._Myspans) {
+            if (_Span.pooled) { // the data has been moved within the literal pool
+                _Span.offset += _Pool_off;
+            }
+
+            _Myspans.push_back(_Span);
+        }
+
+        _Mypositions.insert(_Mypositions.end(), _Other._Mypositions.begin(), _Other._Mypositions.end());
+    }
+
+    void token_stream::discard(const size_t _Count) {
+        // the literal pool is kept intact, the data of the discarded tokens may still be referenced
+        _Mytypes.erase(_Mytypes.begin(), _Mytypes.begin() + _Count);
+        _Myspans.erase(_Myspans.begin(), _Myspans.begin() + _Count);
+        _Mypositions.erase(_Mypositions.begin(), _Mypositions.begin() + _Count);
+    }
+
+    _Token_buffer::_Token_buffer() noexcept : _Myfirst(nullptr), _Mysize(0), _Mycooked(false), _Mystr() {}
+
+    _Token_buffer::~_Token_buffer() noexcept {}
+
+    bool _Token_buffer::_Empty() const noexcept {
+        return _Mycooked ? _Mystr.empty() : _Mysize == 0;
+    }
+
+    bool _Token_buffer::_Cooked() const noexcept {
+        return _Mycooked;
+    }
+
+    byte_string_view _Token_buffer::_View() const noexcept {
+        return _Mycooked ? _Mystr.view() : byte_string_view{_Myfirst, _Mysize};
+    }
+
+    void _Token_buffer::_Cook() {
+        if (!_Mycooked) { // copy the referenced input data once
+            _Mystr.assign(_Myfirst, _Mysize);
+            _Mycooked = true;
+        }
+    }
+
+    void _Token_buffer::_Append(const byte_t* const _Ptr, const size_t _Count) {
+        if (_Mycooked) { // the data is already stored in the internal string
+            _Mystr.append(_Ptr, _Count);
+        } else if (_Mysize == 0) { // start referencing the input data
+            _Myfirst = _Ptr;
+            _Mysize  = _Count;
+        } else if (_Myfirst + _Mysize == _Ptr) { // the characters directly follow the referenced data
+            _Mysize += _Count;
+        } else { // the data is no longer contiguous, copy it
+            _Cook();
+            _Mystr.append(_Ptr, _Count);
+        }
     }
 
-    void token_stream::append(token&& _Token) {
-        _Mytokens.push_back(::std::move(_Token));
+    void _Token_buffer::_Replace_back(const byte_t _Ch) {
+        _Cook();
+        _Mystr.back() = _Ch;
     }
 
+    void _Token_buffer::_Clear() noexcept {
+        _Myfirst = nullptr;
+        _Mysize  = 0;
+        if (_Mycooked) {
+            _Mystr.clear();
+            _Mycooked = false;
+        }
+    }
+
+    _Lexer_iterator::_Lexer_iterator() noexcept : _First(nullptr), _Last(nullptr), _Current(nullptr) {}
+
     _Lexer_iterator::_Lexer_iterator(const byte_string_view _Bytes) noexcept
         : _First(_Bytes.data()), _Last(_First + _Bytes.size()), _Current(_First) {}
 
-    bool _Token_parser::_Is_keyword(const byte_string_view _Token) noexcept {
-        return parse_keyword(_Token) != keyword::none;
-    }
+    _Lexer_iterator::_Lexer_iterator(const byte_string_view _Bytes, const size_t _Off, const size_t _Count) noexcept
+        : _First(_Bytes.data()), _Last(_First + _Off + _Count), _Current(_First + _Off) {}
 
     bool _Token_parser::_Is_identifier(const byte_string_view _Token) noexcept {
         // identifier must start with '#' and must not contain a colon
         return _Token.starts_with('#') && !_Token.contains(':');
     }
 
-    token_type _Token_parser::_Parse_type(const byte_string_view _Token) noexcept {
+    token_type _Token_parser::_Parse_type(const byte_string_view _Token, keyword& _Kw) noexcept {
         constexpr byte_t _LCBracket[] = {'{', '\0'};
         constexpr byte_t _RCBracket[] = {'}', '\0'};
         constexpr byte_t _Colon[]     = {':', '\0'};
-        if (_Is_keyword(_Token)) {
+        _Kw = parse_keyword(_Token);
+        if (_Kw != keyword::none) {
             return token_type::keyword;
         } else if (_Is_identifier(_Token)) {
             return token_type::identifier;
@@ -70,71 +231,65 @@ namespace mjx {
 
     _Analysis_handler::~_Analysis_handler() noexcept {}
 
-    void _Analysis_handler::_Next_line() noexcept {
-        ++_Mycache._Location._Current.line;
-        _Mycache._Location._Current.column = 1; // reset column number
-    }
-
-    void _Analysis_handler::_Capture_current_location() noexcept {
-        _Mycache._Location._Captured = _Mycache._Location._Current;
+    void _Analysis_handler::_Capture_current_position() noexcept {
+        _Mycache._Captured = static_cast<uint32_t>(_Myiter._Current - _Myiter._First);
     }
 
-    void _Analysis_handler::_Maybe_capture_current_location() noexcept {
-        if (_Mycache._Block == _Analysis_block::_Normal && _Mycache._Buf.empty()) {
-            _Capture_current_location();
+    void _Analysis_handler::_Maybe_capture_current_position() noexcept {
+        if (_Mycache._Block == _Analysis_block::_Normal && _Mycache._Buf._Empty()) {
+            _Capture_current_position();
         }
     }
 
     void _Analysis_handler::_Append_token(const token_type _Type) {
-        byte_t _Sign[2] = {'\0'};
-        switch (_Type) {
-        case token_type::left_curly_bracket:
-            *_Sign = '{';
-            break;
-        case token_type::right_curly_bracket:
-            *_Sign = '}';
-            break;
-        case token_type::colon:
-            *_Sign = ':';
-            break;
-        default: // requested token is not trivial, break
-            return;
+        // punctuation tokens carry no data, only the offset of the character is stored
+        _Mycache._Stream.append(token{_Mycache._Captured, _Type, false, _Mycache._Captured});
+    }
+
+    void _Analysis_handler::_Append_buffered_token(const token_type _Type, const keyword _Kw) {
+        _Token_buffer& _Buf          = _Mycache._Buf;
+        const byte_string_view _Data = _Buf._View();
+        token _Token{_Mycache._Captured, _Type};
+        if (_Buf._Cooked()) { // the data is not a contiguous part of the input data, store it in the pool
+            _Token.pooled = true;
+            _Token.offset = _Mycache._Stream.pool(_Data);
+        } else if (!_Data.empty()) { // refer to the input data
+            _Token.offset = static_cast<uint32_t>(_Data.data() - _Myiter._First);
         }
 
-        _Mycache._Stream.append(token{_Mycache._Location._Captured, _Type, _Sign});
+        _Token.length = static_cast<uint32_t>(_Data.size());
+        _Token.kw     = _Kw;
+        _Mycache._Stream.append(_Token);
+        _Buf._Clear(); // clear the buffer
     }
 
     void _Analysis_handler::_Flush_buffer() {
-        byte_string& _Buf = _Mycache._Buf;
-        _Mycache._Stream.append(token{_Mycache._Location._Captured, _Token_parser::_Parse_type(_Buf), _Buf});
-        _Buf.clear(); // clear the buffer
+        keyword _Kw;
+        const token_type _Type = _Token_parser::_Parse_type(_Mycache._Buf._View(), _Kw);
+        _Append_buffered_token(_Type, _Kw);
     }
 
     void _Analysis_handler::_Flush_buffer_as_string_literal() {
-        byte_string& _Buf = _Mycache._Buf;
-        _Mycache._Stream.append(token{_Mycache._Location._Captured, token_type::string_literal, _Buf});
-        _Buf.clear(); // clear the buffer
+        _Append_buffered_token(token_type::string_literal);
     }
 
     void _Analysis_handler::_On_quote() {
         if (_Mycache._Block == _Analysis_block::_Normal) { // found opening quote, switch to string literal block
             _Mycache._Block = _Analysis_block::_String_literal;
-            _Capture_current_location();
+            _Capture_current_position();
         } else if (_Mycache._Block == _Analysis_block::_String_literal) {
             if (_Myiter._Current > _Myiter._First && *(_Myiter._Current - 1) == '\\') {
-                _Mycache._Buf.back() = '"'; // replace slash with quote
+                _Mycache._Buf._Replace_back('"'); // replace slash with quote
             } else { // switch to normal block
                 _Flush_buffer_as_string_literal();
                 _Mycache._Block = _Analysis_block::_Normal;
             }
         }
-
-        ++_Mycache._Location._Current.column;
     }
 
     bool _Analysis_handler::_On_eol() {
         if (_Mycache._Block == _Analysis_block::_Normal) {
-            if (!_Mycache._Buf.empty()) { // append next token to the stream
+            if (!_Mycache._Buf._Empty()) { // append next token to the stream
                 _Flush_buffer();
             }
         } else if (_Mycache._Block == _Analysis_block::_Comment) { // switch to normal block
@@ -143,7 +298,6 @@ namespace mjx {
             return false;
         }
 
-        _Next_line(); // advance to the next line
         return true;
     }
 
@@ -152,112 +306,110 @@ namespace mjx {
             return false;
         }
 
-        _Mycache._Buf.push_back(' '); // append next character to the buffer
-        ++_Mycache._Location._Current.column;
+        _Mycache._Buf._Append(_Myiter._Current, 1); // append next character to the buffer
         return true;
     }
 
     void _Analysis_handler::_On_whitespace() {
-        if (_Mycache._Block == _Analysis_block::_Normal && !_Mycache._Buf.empty()) {
+        if (_Mycache._Block == _Analysis_block::_Normal && !_Mycache._Buf._Empty()) {
             _Flush_buffer(); // append next token to the stream
         }
-
-        ++_Mycache._Location._Current.column;
     }
 
     void _Analysis_handler::_On_slash() {
         if (_Mycache._Block == _Analysis_block::_Normal) {
-            if (_Myiter._Last - _Myiter._Current > 0 && *(_Myiter._Current + 1) == '/') {
+            if (_Myiter._Last - _Myiter._Current > 1 && *(_Myiter._Current + 1) == '/') {
                 _Mycache._Block = _Analysis_block::_Comment; // switch to comment block
-                if (!_Mycache._Buf.empty()) { // append next token to the stream
+                if (!_Mycache._Buf._Empty()) { // append next token to the stream
                     _Flush_buffer();
                 }
             }
         } else if (_Mycache._Block == _Analysis_block::_String_literal) { // append next character to the buffer
-            _Mycache._Buf.push_back('/');
+            _Mycache._Buf._Append(_Myiter._Current, 1);
         }
-
-        ++_Mycache._Location._Current.column;
     }
 
     void _Analysis_handler::_On_colon() {
         if (_Mycache._Block == _Analysis_block::_Normal) { // store colon as a separate token
-            if (!_Mycache._Buf.empty()) { // append next token to the stream
+            if (!_Mycache._Buf._Empty()) { // append next token to the stream
                 _Flush_buffer();
             }
 
-            _Capture_current_location();
+            _Capture_current_position();
             _Append_token(token_type::colon);
         } else if (_Mycache._Block == _Analysis_block::_String_literal) { // append next character to the buffer
-            _Mycache._Buf.push_back(':');
+            _Mycache._Buf._Append(_Myiter._Current, 1);
         }
-
-        ++_Mycache._Location._Current.column;
     }
 
     void _Analysis_handler::_On_left_curly_bracket() {
         if (_Mycache._Block == _Analysis_block::_Normal) { // store left-curly-bracket as a separate token
-            if (!_Mycache._Buf.empty()) { // append next token to the stream
+            if (!_Mycache._Buf._Empty()) { // append next token to the stream
                 _Flush_buffer();
             }
 
-            _Capture_current_location();
+            _Capture_current_position();
             _Append_token(token_type::left_curly_bracket);
         } else if (_Mycache._Block == _Analysis_block::_String_literal) { // append next character to the buffer
-            _Mycache._Buf.push_back('{');
+            _Mycache._Buf._Append(_Myiter._Current, 1);
         }
-
-        ++_Mycache._Location._Current.column;
     }
 
     void _Analysis_handler::_On_right_curly_bracket() {
         if (_Mycache._Block == _Analysis_block::_Normal) { // store right-curly-bracket as a separate token
-            if (!_Mycache._Buf.empty()) { // append next token to the stream
+            if (!_Mycache._Buf._Empty()) { // append next token to the stream
                 _Flush_buffer();
             }
 
-            _Capture_current_location();
+            _Capture_current_position();
             _Append_token(token_type::right_curly_bracket);
         } else if (_Mycache._Block == _Analysis_block::_String_literal) { // append next character to the buffer
-            _Mycache._Buf.push_back('}');
+            _Mycache._Buf._Append(_Myiter._Current, 1);
         }
-
-        ++_Mycache._Location._Current.column;
     }
 
-    void _Analysis_handler::_On_char() {
-        if (_Mycache._Block != _Analysis_block::_Comment) { // append next character to the buffer
-            _Maybe_capture_current_location();
-            _Mycache._Buf.push_back(*_Myiter._Current);
+    void _Analysis_handler::_On_chars() {
+        // Note: Most of the input data consists of long sequences of characters that don't change
+        //       the analysis state (string literals, comments, identifiers). Instead of handling them
+        //       one by one, we search for the next byte that may change the state and handle
+        //       the whole sequence at once. The first character is already known to be ordinary.
+        const byte_t* const _First = _Myiter._Current;
+        const byte_t* _Next;
+        switch (_Mycache._Block) {
+        case _Analysis_block::_Normal:
+            _Next = _Find_structural_byte(_First + 1, _Myiter._Last);
+            _Maybe_capture_current_position();
+            _Mycache._Buf._Append(_First, static_cast<size_t>(_Next - _First));
+            break;
+        case _Analysis_block::_String_literal:
+            _Next = _Find_literal_byte(_First + 1, _Myiter._Last);
+            _Mycache._Buf._Append(_First, static_cast<size_t>(_Next - _First));
+            break;
+        default: // skip the rest of the comment
+            _Next = _Find_eol(_First + 1, _Myiter._Last);
+            break;
         }
 
-        ++_Mycache._Location._Current.column;
+        _Myiter._Current = _Next - 1; // point to the last handled character
     }
 
-    lexical_analyzer::lexical_analyzer(report_counters& _Counters) noexcept
-        : _Mycache(), _Myctrs(_Counters) {}
-
-    lexical_analyzer::~lexical_analyzer() noexcept {}
-
-    bool lexical_analyzer::analyze(const byte_string_view _Input_data) {
-        _Lexer_iterator _Iter(_Input_data);
-        _Analysis_handler _Handler(_Mycache, _Iter);
+    bool _Analyze_bytes(_Lexer_cache& _Cache, _Lexer_iterator& _Iter, const size_t _Limit) {
+        _Analysis_handler _Handler(_Cache, _Iter);
         for (; _Iter._Current != _Iter._Last; ++_Iter._Current) {
             switch (*_Iter._Current) {
             case '"':
                 _Handler._On_quote();
                 break;
             case '\n':
-                if (!_Handler._On_eol()) { // report an error
-                    // Note: The missing quote error is detected only when the current analysis block is
-                    //       a string literal. In such cases, we have captured the location of the current
-                    //       string literal. Therefore, it's preferable to use the captured location
-                    //       instead of the current one, as this provides a more accurate error message.
-                    _Report_error(_Myctrs, L"(%u, %u): error E2016: missing closing quote '\"' for string literal",
-                        _Mycache._Location._Captured.line, _Mycache._Location._Captured.column);
+                if (!_Handler._On_eol()) { // missing closing quote, break
                     return false;
                 }
 
+                if (_Cache._Stream.size() >= _Limit) { // enough tokens, stop at the beginning of the next line
+                    ++_Iter._Current;
+                    return true;
+                }
+
                 break;
             case ' ':
                 if (_Handler._On_space()) {
@@ -284,15 +436,52 @@ namespace mjx {
                 _Handler._On_right_curly_bracket();
                 break;
             default:
-                _Handler._On_char();
+                _Handler._On_chars();
                 break;
             }
+        }
+
+        return true;
+    }
+
+    void _Report_missing_quote(report_counters& _Counters, const token_stream& _Stream, const uint32_t _Position) {
+        // Note: The missing quote error is detected only when the current analysis block is
+        //       a string literal. In such cases, we have captured the position of the current
+        //       string literal. Therefore, it's preferable to use the captured position
+        //       instead of the current one, as this provides a more accurate error message.
+        const token_location _Location = _Stream.locate(_Position);
+        _Report_error(_Counters, L"(%u, %u): error E2016: missing closing quote '\"' for string literal",
+            _Location.line, _Location.column);
+    }
+
+    lexical_analyzer::lexical_analyzer(report_counters& _Counters) noexcept
+        : _Mycache(), _Myiter(), _Myctrs(_Counters) {}
+
+    lexical_analyzer::~lexical_analyzer() noexcept {}
 
+    bool lexical_analyzer::analyze(const byte_string_view _Input_data) {
+        bind_input(_Input_data);
+        return analyze_until(static_cast<size_t>(-1));
+    }
+
+    void lexical_analyzer::bind_input(const byte_string_view _Input_data) noexcept {
+        _Myiter = _Lexer_iterator(_Input_data);
+        _Mycache._Stream.bind_input(_Input_data);
+    }
+
+    bool lexical_analyzer::analyze_until(const size_t _Count) {
+        if (!_Analyze_bytes(_Mycache, _Myiter, _Count)) { // report an error
+            _Report_missing_quote(_Myctrs, _Mycache._Stream, _Mycache._Captured);
+            return false;
         }
 
         return true;
     }
 
+    bool lexical_analyzer::is_done() const noexcept {
+        return _Myiter._Current == _Myiter._Last;
+    }
+
     bool lexical_analyzer::complete_analysis() {
         // Note: This function is called after lexical analysis, with the main purpose of detecting
         //       opened string literals. The analyze() function may not detect a missing closing quote
@@ -300,8 +489,7 @@ namespace mjx {
         //       manually. The analysis block after lexical analysis is expected to be either _Normal
         //       or _Comment, as comments are allowed and completely discarded during analysis.
         if (_Mycache._Block == _Analysis_block::_String_literal) { // report an error
-            _Report_error(_Myctrs, L"(%u, %u): error E2016: missing closing quote '\"' for string literal",
-                _Mycache._Location._Captured.line, _Mycache._Location._Captured.column);
+            _Report_missing_quote(_Myctrs, _Mycache._Stream, _Mycache._Captured);
             return false;
         }
 
@@ -312,11 +500,240 @@ namespace mjx {
         return _Mycache._Stream;
     }
 
+    token_stream& lexical_analyzer::stream() noexcept {
+        return _Mycache._Stream;
+    }
+
+    token_reader::token_reader() noexcept : _Mystream(), _Mylexer(), _Mybase(0), _Myfailed(false) {}
+
+    token_reader::token_reader(token_reader&& _Other) noexcept
+        : _Mystream(::std::move(_Other._Mystream)), _Mylexer(::std::move(_Other._Mylexer)),
+        _Mybase(_Other._Mybase), _Myfailed(_Other._Myfailed) {
+        _Other._Mybase   = 0;
+        _Other._Myfailed = false;
+    }
+
+    token_reader::~token_reader() noexcept {}
+
+    token_reader::token_reader(token_stream&& _Stream) noexcept
+        : _Mystream(::std::move(_Stream)), _Mylexer(), _Mybase(0), _Myfailed(false) {}
+
+    token_reader::token_reader(const byte_string_view _Input_data, report_counters& _Counters)
+        : _Mystream(), _Mylexer(::mjx::make_unique_smart_ptr<lexical_analyzer>(_Counters)),
+        _Mybase(0), _Myfailed(false) {
+        _Mylexer->bind_input(_Input_data);
+    }
+
+    token_reader& token_reader::operator=(token_reader&& _Other) noexcept {
+        if (this != ::std::addressof(_Other)) {
+            _Mystream = ::std::move(_Other._Mystream);
+            _Mylexer  = ::std::move(_Other._Mylexer);
+            _Mybase   = _Other._Mybase;
+            _Myfailed = _Other._Myfailed;
+
+            _Other._Mybase   = 0;
+            _Other._Myfailed = false;
+        }
+
+        return *this;
+    }
+
+    token_stream& token_reader::_Window() noexcept {
+        return _Mylexer ? _Mylexer->stream() : _Mystream;
+    }
+
+    const token_stream& token_reader::_Window() const noexcept {
+        return _Mylexer ? _Mylexer->stream() : _Mystream;
+    }
+
+    bool token_reader::_Analyze_more() {
+        if (!_Mylexer || _Myfailed || _Mylexer->is_done()) { // nothing more to analyze
+            return false;
+        }
+
+        if (!_Mylexer->analyze_until(_Mylexer->stream().size() + _Batch_size)
+            || (_Mylexer->is_done() && !_Mylexer->complete_analysis())) { // analysis failed, error reported
+            _Myfailed = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool token_reader::failed() const noexcept {
+        return _Myfailed;
+    }
+
+    size_t token_reader::size() {
+        while (_Analyze_more()) {} // analyze the rest of the input data
+
+        return _Mybase + _Window().size();
+    }
+
+    bool token_reader::has_token(const size_t _Idx) {
+        if (_Idx < _Mybase) { // the token has been already released
+            return false;
+        }
+
+        while (_Idx - _Mybase >= _Window().size()) {
+            if (!_Analyze_more()) { // no more tokens
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    token token_reader::get_token(const size_t _Idx) {
+        if (!has_token(_Idx)) {
+            resource_overrun::raise();
+        }
+
+        return _Window().get_token(_Idx - _Mybase);
+    }
+
+    bool token_reader::matches(const size_t _Off, const token_type* const _Types, const size_t _Count) {
+        if (_Count > 0 && !has_token(_Off + _Count - 1)) { // not enough tokens
+            return false;
+        }
+
+        return _Window().matches(_Off - _Mybase, _Types, _Count);
+    }
+
+    size_t token_reader::count_consecutive(const size_t _Off, const token_type _Type) {
+        size_t _Count = 0;
+        while (has_token(_Off + _Count)) { // count within the window, then analyze more input data if needed
+            _Count += _Window().count_consecutive(_Off + _Count - _Mybase, _Type);
+            if (_Off + _Count - _Mybase < _Window().size()) { // found a token of a different type
+                break;
+            }
+        }
+
+        return _Count;
+    }
+
+    byte_string_view token_reader::data(const token& _Token) const noexcept {
+        return _Window().data(_Token);
+    }
+
+    token_location token_reader::locate(const uint32_t _Position) const {
+        return _Window().locate(_Position);
+    }
+
+    void token_reader::release(const size_t _Idx) {
+        if (!_Mylexer || _Idx <= _Mybase) { // the tokens are not analyzed on demand or already released
+            return;
+        }
+
+        const size_t _Count = (::std::min)(_Idx - _Mybase, _Window().size());
+        if (_Count >= _Release_threshold) { // discard the released tokens
+            _Window().discard(_Count);
+            _Mybase += _Count;
+        }
+    }
+
+    size_t _Choose_chunk_count(const size_t _Size) noexcept {
+        // Note: The input files are already compiled on the requested number of threads, so the remaining
+        //       processors are shared among them. Each chunk should be large enough to compensate for
+        //       the cost of scheduling a separate task.
+        constexpr size_t _Min_chunk_size = 1024 * 1024;
+        const size_t _Threads            = program_options::current().threads;
+        if (_Threads == _Threads_option_traits::_Disabled) { // multithreading disabled, use a single chunk
+            return 1;
+        }
+
+        const size_t _Max_count = (::std::max)(::mjx::hardware_concurrency() / _Threads, size_t{1});
+        return (::std::min)(_Max_count, (::std::max)(_Size / _Min_chunk_size, size_t{1}));
+    }
+
+    vector<_Lexer_chunk> _Split_into_chunks(const byte_string_view _Data, const size_t _Count) {
+        // Note: String literals and comments never span multiple lines, so the analysis block is always
+        //       _Normal at the beginning of a line. This allows each chunk to be analyzed separately,
+        //       as long as it starts right after an end of line. The boundaries are moved forward
+        //       to the nearest end of line, therefore fewer chunks may be created than requested.
+        const byte_t* const _First = _Data.data();
+        const byte_t* const _Last  = _First + _Data.size();
+        const size_t _Step         = _Data.size() / _Count;
+        vector<size_t> _Bounds;
+        _Bounds.reserve(_Count + 1);
+        _Bounds.push_back(0);
+        for (size_t _Idx = 1; _Idx < _Count; ++_Idx) {
+            const size_t _Off         = (::std::max)(_Idx * _Step, _Bounds.back());
+            const byte_t* const _Next = _Find_eol(_First + _Off, _Last);
+            if (_Last - _Next <= 1) { // no more lines, break
+                break;
+            }
+
+            _Bounds.push_back(static_cast<size_t>(_Next - _First) + 1); // start after the end of line
+        }
+
+        _Bounds.push_back(_Data.size());
+        vector<_Lexer_chunk> _Chunks(_Bounds.size() - 1);
+        for (size_t _Idx = 0; _Idx < _Chunks.size(); ++_Idx) {
+            _Chunks[_Idx]._Off  = _Bounds[_Idx];
+            _Chunks[_Idx]._Size = _Bounds[_Idx + 1] - _Bounds[_Idx];
+        }
+
+        return ::std::move(_Chunks);
+    }
+
+    void _Analyze_chunk(const byte_string_view _Data, _Lexer_chunk& _Chunk) {
+        // the tokens refer to the whole input data, so their positions don't have to be adjusted later
+        _Lexer_iterator _Iter(_Data, _Chunk._Off, _Chunk._Size);
+        _Chunk._Cache._Stream.bind_input(_Data);
+        _Chunk._Success = _Analyze_bytes(_Chunk._Cache, _Iter)
+            && _Chunk._Cache._Block != _Analysis_block::_String_literal;
+    }
+
+    bool _Analyze_in_parallel(
+        const byte_string_view _Data, const size_t _Count, token_stream& _Stream, report_counters& _Counters) {
+        vector<_Lexer_chunk> _Chunks = _Split_into_chunks(_Data, _Count);
+        if (_Chunks.size() > 1) { // analyze all but the first chunk on the thread-pool's threads
+            thread_pool _Pool(_Chunks.size() - 1);
+            vector<task> _Tasks;
+            _Tasks.reserve(_Chunks.size() - 1);
+            for (size_t _Idx = 1; _Idx < _Chunks.size(); ++_Idx) {
+                task _Task = ::mjx::async(_Pool,
+                    [_Data, &_Chunk = _Chunks[_Idx]] {
+                        _Analyze_chunk(_Data, _Chunk);
+                    }
+                );
+                if (_Task.is_registered()) { // the chunk will be analyzed on the thread-pool's thread
+                    _Tasks.push_back(::std::move(_Task));
+                } else { // failed to schedule the task, analyze the chunk on this thread
+                    _Analyze_chunk(_Data, _Chunks[_Idx]);
+                }
+            }
+
+            _Analyze_chunk(_Data, _Chunks[0]); // analyze the first chunk on this thread
+            for (task& _Task : _Tasks) {
+                _Task.wait_until_done();
+            }
+        } else { // only one chunk, analyze it on this thread
+            _Analyze_chunk(_Data, _Chunks[0]);
+        }
+
+        // Note: The tokens of each chunk refer to the whole input data, so the streams can be simply
+        //       concatenated. Errors are reported only for the first chunk that failed, just like
+        //       the sequential analysis stops at the first missing quote.
+        _Stream.bind_input(_Data);
+        for (size_t _Idx = 0; _Idx < _Chunks.size(); ++_Idx) {
+            const _Lexer_chunk& _Chunk = _Chunks[_Idx];
+            if (!_Chunk._Success) { // report an error
+                _Report_missing_quote(_Counters, _Stream, _Chunk._Cache._Captured);
+                return false;
+            }
+
+            _Stream.append(_Chunk._Cache._Stream);
+        }
+
+        return true;
+    }
+
     analysis_result analyze_input_file(const path& _Target, report_counters& _Counters) {
         clog(L"> Starting lexical analysis");
         file _File(_Target, file_access::read, file_share::read);
-        file_stream _Stream(_File);
-        if (!_Stream.is_open()) { // cannot open the input file
+        if (!_File.is_open()) { // cannot open the input file
             _Report_error(_Counters, L"(?, ?): error E1000: cannot open input file '%s'", _Target.c_str());
             return analysis_result{false};
         }
@@ -331,53 +748,55 @@ namespace mjx {
             }
         }
 
-        lexical_analyzer _Lexer(_Counters);
+        if (_File.size() > (::std::numeric_limits<uint32_t>::max)()) { // tokens use 32-bit offsets
+            _Report_error(_Counters, L"(?, ?): error E1004: input file '%s' is too large", _Target.c_str());
+            return analysis_result{false};
+        }
+
+        mapped_file _Input(_File);
+        if (!_Input.is_open()) { // cannot read the input file
+            _Report_error(_Counters, L"(?, ?): error E1003: cannot read input file '%s'", _Target.c_str());
+            return analysis_result{false};
+        }
+
+        token_reader _Reader;
         bool _Success        = true;
+        bool _On_demand      = false;
         const float _Elapsed = measure_invoke_duration(
             [&] {
-                bool _Check_bom            = true;
-                constexpr size_t _Buf_size = 4096;
-                byte_t _Buf[_Buf_size];
-                size_t _Read;
-                for (;;) { // analyze the file chunk by chunk
-                    _Read = _Stream.read(_Buf, _Buf_size);
-                    if (_Read == 0) { // no more data, break
-                        break;
-                    }
-
-                    if (_Check_bom) { // check for presence of any BOM
-                        _Check_bom                = false; // check it once
-                        const _Bom& _Detected_bom = _Bom_detector::_Detect(byte_string_view{_Buf, _Read});
-                        switch (_Detected_bom._Kind) {
-                        case _Bom_kind::_None: // BOM not present, do nothing
-                            break;
-                        case _Bom_kind::_Utf8: // detected UTF-8 BOM, discard and continue
-                            using _Traits = char_traits<byte_t>;
-                            _Read        -= _Detected_bom._Size;
-                            _Traits::move(_Buf, _Buf + _Detected_bom._Size, _Read);
-                            break;
-                        default: // detected unsupported BOM, break
-                            _Success = false;
-                            _Report_error(
-                                _Counters, L"(?, ?): error E1002: detected unsupported encoding");
-                            return;
-                        }
-                    }
-
-                    if (!_Lexer.analyze(byte_string_view{_Buf, _Read})) { // analysis failed, break
-                        _Success = false;
-                        return;
-                    }
+                byte_string_view _Data    = _Input.view();
+                const _Bom& _Detected_bom = _Bom_detector::_Detect(_Data);
+                switch (_Detected_bom._Kind) {
+                case _Bom_kind::_None: // BOM not present, do nothing
+                    break;
+                case _Bom_kind::_Utf8: // detected UTF-8 BOM, skip it
+                    _Data.remove_prefix(_Detected_bom._Size);
+                    break;
+                default: // detected unsupported BOM, break
+                    _Success = false;
+                    _Report_error(_Counters, L"(?, ?): error E1002: detected unsupported encoding");
+                    return;
                 }
 
-                if (!_Lexer.complete_analysis()) { // analysis completion failed
-                    _Success = false;
+                const size_t _Chunks = _Choose_chunk_count(_Data.size());
+                if (_Chunks > 1) { // analyze line-aligned chunks of the input data on multiple threads
+                    token_stream _Stream;
+                    _Success = _Analyze_in_parallel(_Data, _Chunks, _Stream, _Counters);
+                    _Reader  = token_reader(::std::move(_Stream));
+                } else { // analyze the input data on demand, as the parser requests the tokens
+                    _Reader    = token_reader(_Data, _Counters);
+                    _On_demand = true;
                 }
             }
         );
         if (_Success) {
-            clog(L"> Completed lexical analysis (took %.5fs)", _Elapsed);
-            return analysis_result{true, _Lexer.stream()};
+            if (_On_demand) { // the tokens will be analyzed during parse
+                clog(L"> Deferred lexical analysis until parse (took %.5fs)", _Elapsed);
+            } else {
+                clog(L"> Completed lexical analysis (took %.5fs)", _Elapsed);
+            }
+
+            return analysis_result{true, ::std::move(_Reader), ::std::move(_Input)};
         } else { // something went wrong
             return analysis_result{false};
         }
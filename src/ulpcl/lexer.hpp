@@ -8,8 +8,11 @@
 #define _ULPCL_LEXER_HPP_
 #include <cstdint>
 #include <mjfs/path.hpp>
+#include <mjmem/smart_pointer.hpp>
 #include <mjstr/string.hpp>
 #include <mjstr/string_view.hpp>
+#include <ulpcl/keyword.hpp>
+#include <ulpcl/mapped_file.hpp>
 #include <ulpcl/utils.hpp>
 
 namespace mjx {
@@ -29,12 +32,22 @@ namespace mjx {
     };
 
     struct token {
-        token_location location;
-        token_type type = token_type::none;
-        byte_string data;
+        uint32_t position = 0; // offset of the first character of the token within the input data
+        token_type type   = token_type::none;
+        bool pooled     = false; // true if the data is stored in the literal pool instead of the input data
+        uint32_t offset = 0; // offset of the data within the input data or the literal pool
+        uint32_t length = 0; // always zero for punctuation tokens
+        keyword kw      = keyword::none; // recognized keyword, set only for keyword tokens
     };
 
-    class token_stream { // stores a sequence of tokens
+    struct token_span { // locates the data of a token
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        bool pooled     = false;
+        keyword kw      = keyword::none;
+    };
+
+    class token_stream { // stores a sequence of tokens as separate arrays of types, spans and positions
     public:
         token_stream() noexcept               = default;
         token_stream(const token_stream&)     = default;
@@ -48,14 +61,61 @@ namespace mjx {
         size_t size() const noexcept;
 
         // returns the specified token
-        const token& get_token(const size_t _Idx) const;
+        token get_token(const size_t _Idx) const;
+
+        // returns the type of the specified token
+        token_type get_type(const size_t _Idx) const;
+
+        // returns the data of the specified token
+        byte_string_view data(const token& _Token) const noexcept;
+
+        // returns the line and column of the specified position within the input data
+        token_location locate(const uint32_t _Position) const;
+
+        // checks if the types of the tokens starting at _Off match the specified sequence
+        bool matches(const size_t _Off, const token_type* const _Types, const size_t _Count) const noexcept;
+
+        template <size_t _Count>
+        bool matches(const size_t _Off, const token_type (&_Types)[_Count]) const noexcept {
+            return matches(_Off, _Types, _Count);
+        }
+
+        // returns the number of consecutive tokens of the specified type starting at _Off
+        size_t count_consecutive(const size_t _Off, const token_type _Type) const noexcept;
+
+        // returns the input data the tokens refer to
+        byte_string_view input() const noexcept;
+
+        // binds the input data the tokens refer to, it must outlive the stream
+        void bind_input(const byte_string_view _Input) noexcept;
+
+        // stores the data that is not a contiguous part of the input data in the literal pool
+        uint32_t pool(const byte_string_view _Data);
 
         // appends a new token
         void append(const token& _Token);
-        void append(token&& _Token);
+
+        // appends the tokens of another stream that refers to the same input data
+        void append(const token_stream& _Other);
+
+        // removes the specified number of tokens from the beginning of the stream
+        void discard(const size_t _Count);
 
     private:
-        vector<token> _Mytokens;
+        // Note: The parser mostly examines token types, so they are stored separately from
+        //       the rest of the token data. This keeps them densely packed and allows the parser
+        //       to compare whole sequences of types at once.
+        vector<token_type> _Mytypes;
+        vector<token_span> _Myspans;
+        vector<uint32_t> _Mypositions;
+        byte_string_view _Myinput;
+        byte_string _Mypool; // stores string literals that differ from their source, e.g. contain escapes
+
+        // Note: Locations are needed only to report diagnostics, so the tokens store just their positions.
+        //       The offsets of the line beginnings are collected once the first location is requested.
+        //       The index is built lazily from a const member function, so a stream must not be
+        //       located from multiple threads at once.
+        mutable vector<uint32_t> _Mylines;
     };
 
     enum class _Analysis_block : unsigned char {
@@ -64,15 +124,46 @@ namespace mjx {
         _String_literal // skip analysis until the closing quote is encountered
     };
 
-    struct _Lexer_location {
-        token_location _Current = {1, 1};
-        token_location _Captured;
+    class _Token_buffer { // accumulates the data of the next token
+    public:
+        _Token_buffer() noexcept;
+        ~_Token_buffer() noexcept;
+
+        _Token_buffer(const _Token_buffer&)            = delete;
+        _Token_buffer& operator=(const _Token_buffer&) = delete;
+
+        // checks if the buffer is empty
+        bool _Empty() const noexcept;
+
+        // checks if the data is stored in the internal string instead of the input data
+        bool _Cooked() const noexcept;
+
+        // returns the accumulated data
+        byte_string_view _View() const noexcept;
+
+        // appends a sequence of input characters to the buffer
+        void _Append(const byte_t* const _Ptr, const size_t _Count);
+
+        // replaces the last character in the buffer
+        void _Replace_back(const byte_t _Ch);
+
+        // clears the buffer
+        void _Clear() noexcept;
+
+    private:
+        // copies the referenced input data to the internal string
+        void _Cook();
+
+        const byte_t* _Myfirst; // the first character of the referenced input data
+        size_t _Mysize;
+        bool _Mycooked;
+        byte_string _Mystr; // used only if the data is not a contiguous part of the input data
     };
 
     struct _Lexer_cache { // stores data that is shared between lexical analyzer and analysis handler
         token_stream _Stream;
-        byte_string _Buf;
-        _Lexer_location _Location;
+        _Token_buffer _Buf;
+        uint32_t _Captured = 0; // position of the first character of the next token
         _Analysis_block _Block = _Analysis_block::_Normal;
     };
 
@@ -81,18 +172,17 @@ namespace mjx {
         const byte_t* _Last;
         const byte_t* _Current;
 
+        _Lexer_iterator() noexcept;
         explicit _Lexer_iterator(const byte_string_view _Bytes) noexcept;
+        _Lexer_iterator(const byte_string_view _Bytes, const size_t _Off, const size_t _Count) noexcept;
     };
 
     struct _Token_parser {
-        // checks if the token is a keyword
-        static bool _Is_keyword(const byte_string_view _Token) noexcept;
-
         // checks if the token is an identifier
         static bool _Is_identifier(const byte_string_view _Token) noexcept;
 
-        // parses the token type
-        static token_type _Parse_type(const byte_string_view _Token) noexcept;
+        // parses the token type, stores the recognized keyword in _Kw
+        static token_type _Parse_type(const byte_string_view _Token, keyword& _Kw) noexcept;
     };
 
     class _Analysis_handler {
@@ -128,22 +218,22 @@ namespace mjx {
         // handles the occurrence of right-curly-bracket during lexical analysis
         void _On_right_curly_bracket();
 
-        // handles the occurrence of character during lexical analysis
-        void _On_char();
+        // handles the occurrence of a sequence of characters during lexical analysis
+        void _On_chars();
     
     private:
-        // advances to the next line
-        void _Next_line() noexcept;
-
-        // captures the current location
-        void _Capture_current_location() noexcept;
+        // captures the current position
+        void _Capture_current_position() noexcept;
 
-        // captures the current location if needed
-        void _Maybe_capture_current_location() noexcept;
+        // captures the current position if needed
+        void _Maybe_capture_current_position() noexcept;
 
         // appends a trivial token
         void _Append_token(const token_type _Type);
 
+        // appends a new token of the specified type from the buffer
+        void _Append_buffered_token(const token_type _Type, const keyword _Kw = keyword::none);
+
         // appends a new token from the buffer
         void _Flush_buffer();
 
@@ -154,8 +244,15 @@ namespace mjx {
         _Lexer_iterator& _Myiter;
     };
 
+    // breaks the bytes referenced by the iterator into tokens, returns false if a closing quote is missing;
+    // stops at the end of the line at which the stream holds at least _Limit tokens
+    bool _Analyze_bytes(
+        _Lexer_cache& _Cache, _Lexer_iterator& _Iter, const size_t _Limit = static_cast<size_t>(-1));
+
     struct report_counters;
 
+    void _Report_missing_quote(report_counters& _Counters, const token_stream& _Stream, const uint32_t _Position);
+
     class lexical_analyzer { // breaks an input data into tokens
     public:
         explicit lexical_analyzer(report_counters& _Counters) noexcept;
@@ -165,23 +262,114 @@ namespace mjx {
         lexical_analyzer(const lexical_analyzer&)            = delete;
         lexical_analyzer& operator=(const lexical_analyzer&) = delete;
 
-        // analyzes the input data
+        // analyzes the input data, the data must outlive the token stream
         bool analyze(const byte_string_view _Input_data);
 
+        // binds the input data that will be analyzed incrementally, the data must outlive the token stream
+        void bind_input(const byte_string_view _Input_data) noexcept;
+
+        // analyzes the bound input data until the stream holds at least _Count tokens or the data ends
+        bool analyze_until(const size_t _Count);
+
+        // checks if the whole bound input data has been analyzed
+        bool is_done() const noexcept;
+
         // completes the lexical analysis
         bool complete_analysis();
 
         // returns the associated token stream
         const token_stream& stream() const noexcept;
+        token_stream& stream() noexcept;
 
     private:
         _Lexer_cache _Mycache;
+        _Lexer_iterator _Myiter;
         report_counters& _Myctrs;
     };
 
+    class token_reader { // provides tokens to the parser, either from a complete stream or analyzed on demand
+    public:
+        token_reader() noexcept;
+        token_reader(token_reader&& _Other) noexcept;
+        ~token_reader() noexcept;
+
+        explicit token_reader(token_stream&& _Stream) noexcept;
+        token_reader(const byte_string_view _Input_data, report_counters& _Counters);
+
+        token_reader& operator=(token_reader&& _Other) noexcept;
+
+        token_reader(const token_reader&)            = delete;
+        token_reader& operator=(const token_reader&) = delete;
+
+        // checks if the lexical analysis failed
+        bool failed() const noexcept;
+
+        // returns the total number of tokens, analyzes the rest of the input data if needed
+        size_t size();
+
+        // checks if the specified token exists, analyzes more input data if needed
+        bool has_token(const size_t _Idx);
+
+        // returns the specified token
+        token get_token(const size_t _Idx);
+
+        // checks if the types of the tokens starting at _Off match the specified sequence
+        bool matches(const size_t _Off, const token_type* const _Types, const size_t _Count);
+
+        template <size_t _Count>
+        bool matches(const size_t _Off, const token_type (&_Types)[_Count]) {
+            return matches(_Off, _Types, _Count);
+        }
+
+        // returns the number of consecutive tokens of the specified type starting at _Off
+        size_t count_consecutive(const size_t _Off, const token_type _Type);
+
+        // returns the data of the specified token
+        byte_string_view data(const token& _Token) const noexcept;
+
+        // returns the line and column of the specified position within the input data
+        token_location locate(const uint32_t _Position) const;
+
+        // releases the tokens that precede the specified one, they must not be accessed anymore
+        void release(const size_t _Idx);
+
+    private:
+        static constexpr size_t _Batch_size        = 4096; // the number of tokens analyzed at once
+        static constexpr size_t _Release_threshold = 4096; // the number of tokens released at once
+
+        // returns the stream that holds the available tokens
+        token_stream& _Window() noexcept;
+        const token_stream& _Window() const noexcept;
+
+        // analyzes the next part of the input data, returns false if there is nothing more to analyze
+        bool _Analyze_more();
+
+        // Note: If the tokens are analyzed on demand, only a small window of them is kept in memory.
+        //       The window starts at the first token that has not been released, tokens are still
+        //       accessed by their absolute index.
+        token_stream _Mystream; // used only if the tokens are not analyzed on demand
+        unique_smart_ptr<lexical_analyzer> _Mylexer;
+        size_t _Mybase; // absolute index of the first token in the window
+        bool _Myfailed;
+    };
+
+    struct _Lexer_chunk { // line-aligned part of the input data that is analyzed separately
+        size_t _Off   = 0;
+        size_t _Size  = 0;
+        bool _Success = false;
+        _Lexer_cache _Cache;
+    };
+
+    size_t _Choose_chunk_count(const size_t _Size) noexcept;
+    vector<_Lexer_chunk> _Split_into_chunks(const byte_string_view _Data, const size_t _Count);
+    void _Analyze_chunk(const byte_string_view _Data, _Lexer_chunk& _Chunk);
+    bool _Analyze_in_parallel(
+        const byte_string_view _Data, const size_t _Count, token_stream& _Stream, report_counters& _Counters);
+
     struct analysis_result {
         bool success;
-        token_stream stream;
+        token_reader reader;
+        mapped_file input; // referenced by the reader
     };
 
     analysis_result analyze_input_file(const path& _Target, report_counters& _Counters);
@@ -120,6 +120,23 @@ namespace mjx {
         _Myimpl.reset();
     }
 
+    bool& _Get_log_mute_flag() noexcept {
+        static thread_local bool _Muted = false;
+        return _Muted;
+    }
+
+    compilation_log_mute::compilation_log_mute() noexcept : _Myprev(_Get_log_mute_flag()) {
+        _Get_log_mute_flag() = true;
+    }
+
+    compilation_log_mute::~compilation_log_mute() noexcept {
+        _Get_log_mute_flag() = _Myprev;
+    }
+
+    bool compilation_log_mute::is_active() noexcept {
+        return _Get_log_mute_flag();
+    }
+
     void notify_compilation_finish() noexcept {
         // request a buffer flush if the logger is active and buffered
         compilation_logger& _Logger = compilation_logger::current();
@@ -130,11 +130,26 @@ namespace mjx {
         unique_smart_ptr<_Logger_base> _Myimpl;
     };
 
+    class compilation_log_mute { // suppresses the compilation log on the calling thread while it exists
+    public:
+        compilation_log_mute() noexcept;
+        ~compilation_log_mute() noexcept;
+
+        compilation_log_mute(const compilation_log_mute&)            = delete;
+        compilation_log_mute& operator=(const compilation_log_mute&) = delete;
+
+        // checks if the compilation log is suppressed on the calling thread
+        static bool is_active() noexcept;
+
+    private:
+        bool _Myprev; // the previous state, restored on destruction
+    };
+
     template <class... _Types>
     inline void clog(const unicode_string_view _Fmt, const _Types&... _Args) {
         // write formatted message to the compilation log
         compilation_logger& _Logger = compilation_logger::current();
-        if (_Logger.is_active()) {
+        if (_Logger.is_active() && !compilation_log_mute::is_active()) {
             _Logger.write(_Fmt, _Args...);
         }
     }
@@ -0,0 +1,185 @@
+// lz_codec.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdint>
+#include <cstring>
+#include <ulpcl/lz_codec.hpp>
+#include <ulpcl/utils.hpp>
+
+namespace mjx {
+    struct _Lz_traits {
+        static constexpr size_t _Min_match     = 4;
+        static constexpr size_t _Max_offset    = 0xFFFF;
+        static constexpr size_t _Last_literals = 5; // the last bytes of a block are always literals
+        static constexpr size_t _Match_limit   = 12; // the last match must start before the last 12 bytes
+        static constexpr size_t _Hash_log      = 12;
+        static constexpr byte_t _Length_mask   = 0x0F;
+
+        // reads 4 bytes starting at _Ptr
+        static uint32_t _Read_u32(const byte_t* const _Ptr) noexcept {
+            uint32_t _Value;
+            ::memcpy(&_Value, _Ptr, sizeof(uint32_t));
+            return _Value;
+        }
+
+        // hashes 4 bytes into the hash table index
+        static size_t _Hash(const uint32_t _Sequence) noexcept {
+            return static_cast<size_t>((_Sequence * 2654435761U) >> (32 - _Hash_log));
+        }
+
+        // appends the length that exceeds the token's nibble
+        static void _Append_length(size_t _Length, byte_string& _Out) {
+            for (; _Length >= 255; _Length -= 255) {
+                _Out.push_back(255);
+            }
+
+            _Out.push_back(static_cast<byte_t>(_Length));
+        }
+
+        // appends a sequence of literals followed by an optional match
+        static void _Append_sequence(const byte_t* const _Literals, const size_t _Literal_count,
+            const size_t _Offset, const size_t _Match_length, byte_string& _Out) {
+            const size_t _Match_extra = _Match_length != 0 ? _Match_length - _Min_match : 0;
+            const byte_t _Token       = static_cast<byte_t>(
+                ((_Literal_count < 15 ? _Literal_count : 15) << 4) | (_Match_extra < 15 ? _Match_extra : 15));
+            _Out.push_back(_Token);
+            if (_Literal_count >= 15) {
+                _Append_length(_Literal_count - 15, _Out);
+            }
+
+            _Out.append(_Literals, _Literal_count);
+            if (_Match_length == 0) { // the last sequence has no match
+                return;
+            }
+
+            _Out.push_back(static_cast<byte_t>(_Offset & 0xFF));
+            _Out.push_back(static_cast<byte_t>(_Offset >> 8));
+            if (_Match_extra >= 15) {
+                _Append_length(_Match_extra - 15, _Out);
+            }
+        }
+    };
+
+    void lz_compress(const byte_string_view _Block, byte_string& _Out) {
+        // Note: The matches are found using a hash table of the recent positions of 4-byte sequences,
+        //       and each match is extended as far as the format allows. This is a greedy strategy,
+        //       that trades some of the compression ratio for speed.
+        const byte_t* const _Data = _Block.data();
+        const size_t _Size        = _Block.size();
+        size_t _Anchor            = 0; // the first byte not yet emitted
+        if (_Size > _Lz_traits::_Match_limit) {
+            vector<uint32_t> _Table(size_t{1} << _Lz_traits::_Hash_log, 0); // position + 1, 0 if empty
+            const size_t _Last_match = _Size - _Lz_traits::_Match_limit;
+            const size_t _Match_end  = _Size - _Lz_traits::_Last_literals;
+            for (size_t _Pos = 0; _Pos <= _Last_match;) {
+                const uint32_t _Sequence = _Lz_traits::_Read_u32(_Data + _Pos);
+                uint32_t& _Slot          = _Table[_Lz_traits::_Hash(_Sequence)];
+                const size_t _Candidate  = _Slot;
+                _Slot                    = static_cast<uint32_t>(_Pos + 1);
+                if (_Candidate == 0 || _Pos - (_Candidate - 1) > _Lz_traits::_Max_offset
+                    || _Lz_traits::_Read_u32(_Data + _Candidate - 1) != _Sequence) { // no match, try the next byte
+                    ++_Pos;
+                    continue;
+                }
+
+                const size_t _Ref = _Candidate - 1;
+                size_t _Length    = _Lz_traits::_Min_match;
+                while (_Pos + _Length < _Match_end && _Data[_Ref + _Length] == _Data[_Pos + _Length]) {
+                    ++_Length;
+                }
+
+                _Lz_traits::_Append_sequence(_Data + _Anchor, _Pos - _Anchor, _Pos - _Ref, _Length, _Out);
+                _Pos   += _Length;
+                _Anchor = _Pos;
+            }
+        }
+
+        _Lz_traits::_Append_sequence(_Data + _Anchor, _Size - _Anchor, 0, 0, _Out);
+    }
+
+    bool lz_decompress(const byte_string_view _Data, const size_t _Size, byte_string& _Out) {
+        // Note: The decompressed size is known in advance, so the output is resized once and the sequences
+        //       are copied into it directly. The output is restored to its original size on failure.
+        //       Each byte of the block decodes into at most 255 bytes, so a larger size must be invalid.
+        if (_Size / 255 > _Data.size()) { // the block cannot decode into _Size bytes, break
+            return false;
+        }
+
+        const size_t _Base = _Out.size();
+        _Out.resize(_Base + _Size);
+        byte_t* const _Dest     = _Out.data() + _Base;
+        size_t _Written         = 0;
+        size_t _Pos             = 0;
+        const auto _Read_length = [&](size_t& _Length) noexcept {
+            byte_t _Byte;
+            do {
+                if (_Pos >= _Data.size()) { // truncated length, break
+                    return false;
+                }
+
+                _Byte    = _Data[_Pos++];
+                _Length += _Byte;
+            } while (_Byte == 255);
+
+            return true;
+        };
+        const auto _Decompress = [&]() noexcept {
+            while (_Pos < _Data.size()) {
+                const byte_t _Token   = _Data[_Pos++];
+                size_t _Literal_count = _Token >> 4;
+                if (_Literal_count == 15 && !_Read_length(_Literal_count)) {
+                    return false;
+                }
+
+                if (_Literal_count > _Data.size() - _Pos || _Literal_count > _Size - _Written) {
+                    return false; // truncated literals or too long block, break
+                }
+
+                ::memcpy(_Dest + _Written, _Data.data() + _Pos, _Literal_count);
+                _Written += _Literal_count;
+                _Pos     += _Literal_count;
+                if (_Pos == _Data.size()) { // the last sequence has no match
+                    break;
+                }
+
+                if (_Data.size() - _Pos < 2) { // truncated offset, break
+                    return false;
+                }
+
+                const size_t _Offset = static_cast<size_t>(_Data[_Pos]) | (static_cast<size_t>(_Data[_Pos + 1]) << 8);
+                size_t _Length       = _Token & _Lz_traits::_Length_mask;
+                _Pos                += 2;
+                if (_Length == 15 && !_Read_length(_Length)) {
+                    return false;
+                }
+
+                _Length += _Lz_traits::_Min_match;
+                if (_Offset == 0 || _Offset > _Written || _Length > _Size - _Written) { // malformed match, break
+                    return false;
+                }
+
+                byte_t* const _Match = _Dest + _Written;
+                if (_Offset >= _Length) { // the match doesn't overlap the copied bytes
+                    ::memcpy(_Match, _Match - _Offset, _Length);
+                } else { // the match repeats the last _Offset bytes
+                    for (size_t _Idx = 0; _Idx < _Length; ++_Idx) {
+                        _Match[_Idx] = _Match[_Idx - _Offset];
+                    }
+                }
+
+                _Written += _Length;
+            }
+
+            return _Written == _Size;
+        };
+
+        if (!_Decompress()) { // malformed block, restore the output
+            _Out.resize(_Base);
+            return false;
+        }
+
+        return true;
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,24 @@
+// lz_codec.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_LZ_CODEC_HPP_
+#define _ULPCL_LZ_CODEC_HPP_
+#include <cstddef>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    // Note: The codec produces the LZ4 block format, so that the blocks it compresses can also be
+    //       decompressed by any LZ4 implementation. Each block is compressed independently.
+
+    // appends the compressed block to _Out
+    void lz_compress(const byte_string_view _Block, byte_string& _Out);
+
+    // appends the decompressed block of the specified size to _Out, fails if the block is malformed
+    bool lz_decompress(const byte_string_view _Data, const size_t _Size, byte_string& _Out);
+} // namespace mjx
+
+#endif // _ULPCL_LZ_CODEC_HPP_
\ No newline at end of file
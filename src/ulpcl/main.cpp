@@ -5,6 +5,7 @@
 
 #include <mjstr/char_traits.hpp>
 #include <ulpcl/dispatcher.hpp>
+#include <ulpcl/id_map.hpp>
 #include <ulpcl/logger.hpp>
 #include <ulpcl/program.hpp>
 #include <ulpcl/runtime.hpp>
@@ -57,8 +58,20 @@ namespace mjx {
             L"        <number>                  allow multithreading (user-specified number of threads,"
             L" limited to: 1, 2, 4, 8)\n"
             L"\n"
+            L"    --compression=[...]       specify how message values are stored\n"
+            L"        none                      store values as they are\n"
+            L"        fsst                      compress each value with a trained symbol table\n"
+            L"        lz                        compress the blob in 64 KiB blocks\n"
+            L"        default                   alias for 'none'\n"
+            L"\n"
             L"    --discard-empty (or -d)   discard messages that have no values\n"
-            L"    --symbol-file (or -s)     generate a symbol file for each input file"
+            L"    --symbol-file (or -s)     generate a symbol file for each input file\n"
+            L"    --hash-header             generate a C++ header with message ID hashes for each input file\n"
+            L"    --sort-lookup-table       sort the lookup table by message ID hashes\n"
+            L"    --perfect-hash-index      index the lookup table with a minimal perfect hash function\n"
+            L"    --merge-tails             store values that are tails of other values within them\n"
+            L"    --aligned-layout          align sections to 64 bytes and store hashes in a separate array\n"
+            L"    --ordinal-ids             index values by ordinals stored in an ID map shared by all packs"
         );
     }
 
@@ -88,10 +101,15 @@ namespace mjx {
 
     inline void _Start_build() {
         rtlog(L"Build started at %s...", get_current_time<wchar_t>().c_str());
+        if (!load_id_map()) { // the ordinals would not be stable, break
+            return;
+        }
+
         compilation_counters _Counters;
         const float _Elapsed = measure_invoke_duration(
             [&_Counters] {
                 // dispatch compilation for each input file and wait until the entire compilation is completed
+                extend_id_map(); // the ordinals must be known before any pack is compiled
                 compilation_dispatcher _Dispatcher;
                 for (const path& _Input_file : program_options::current().input_files) {
                     _Dispatcher.dispatch(_Input_file);
@@ -99,6 +117,10 @@ namespace mjx {
 
                 _Dispatcher.wait_for_completion();
                 _Counters = _Dispatcher.counters();
+                if (!save_id_map(_Counters.failed == 0)) { // the ordinals stored in the packs were not persisted
+                    _Counters.failed   += _Counters.succeeded;
+                    _Counters.succeeded = 0;
+                }
             }
         );
         rtlog(L"\n----- Build: %zu succeeded, %zu failed", _Counters.succeeded, _Counters.failed);
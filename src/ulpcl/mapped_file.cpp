@@ -0,0 +1,107 @@
+// mapped_file.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <limits>
+#include <mjfs/file_stream.hpp>
+#include <type_traits>
+#include <ulpcl/mapped_file.hpp>
+#include <ulpcl/tinywin.hpp>
+
+namespace mjx {
+    mapped_file::mapped_file() noexcept : _Mymapping(nullptr), _Mydata(nullptr), _Mysize(0), _Mybuf() {}
+
+    mapped_file::mapped_file(mapped_file&& _Other) noexcept
+        : _Mymapping(_Other._Mymapping), _Mydata(_Other._Mydata),
+        _Mysize(_Other._Mysize), _Mybuf(::std::move(_Other._Mybuf)) {
+        _Other._Mymapping = nullptr;
+        _Other._Mydata    = nullptr;
+        _Other._Mysize    = 0;
+    }
+
+    mapped_file::~mapped_file() noexcept {
+        close();
+    }
+
+    mapped_file::mapped_file(file& _File) : _Mymapping(nullptr), _Mydata(nullptr), _Mysize(0), _Mybuf() {
+        const uint64_t _Size = _File.size();
+        if (_Size == 0 || _Size > (::std::numeric_limits<size_t>::max)()) { // nothing to map or too large
+            return;
+        }
+
+        if (!_Map(_File, static_cast<size_t>(_Size))) { // mapping failed, read the whole file instead
+            _Read(_File, static_cast<size_t>(_Size));
+        }
+    }
+
+    mapped_file& mapped_file::operator=(mapped_file&& _Other) noexcept {
+        if (this != ::std::addressof(_Other)) {
+            close();
+            _Mymapping = _Other._Mymapping;
+            _Mydata    = _Other._Mydata;
+            _Mysize    = _Other._Mysize;
+            _Mybuf     = ::std::move(_Other._Mybuf);
+
+            _Other._Mymapping = nullptr;
+            _Other._Mydata    = nullptr;
+            _Other._Mysize    = 0;
+        }
+
+        return *this;
+    }
+
+    bool mapped_file::_Map(file& _File, const size_t _Size) noexcept {
+        _Mymapping = ::CreateFileMappingW(_File.native_handle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_Mymapping) { // failed to create a file mapping
+            return false;
+        }
+
+        _Mydata = static_cast<const byte_t*>(::MapViewOfFile(_Mymapping, FILE_MAP_READ, 0, 0, 0));
+        if (!_Mydata) { // failed to map a view of the file, close the mapping
+            ::CloseHandle(_Mymapping);
+            _Mymapping = nullptr;
+            return false;
+        }
+
+        _Mysize = _Size;
+        return true;
+    }
+
+    bool mapped_file::_Read(file& _File, const size_t _Size) {
+        file_stream _Stream(_File);
+        _Mybuf = ::mjx::make_unique_smart_array<byte_t>(_Size);
+        if (!_Stream.read_exactly(_Mybuf.get(), _Size)) { // failed to read the whole file
+            _Mybuf.reset();
+            return false;
+        }
+
+        _Mydata = _Mybuf.get();
+        _Mysize = _Size;
+        return true;
+    }
+
+    bool mapped_file::is_open() const noexcept {
+        return _Mydata != nullptr;
+    }
+
+    bool mapped_file::is_mapped() const noexcept {
+        return _Mymapping != nullptr;
+    }
+
+    byte_string_view mapped_file::view() const noexcept {
+        return byte_string_view{_Mydata, _Mysize};
+    }
+
+    void mapped_file::close() noexcept {
+        if (_Mymapping) { // unmap the view and close the mapping
+            ::UnmapViewOfFile(_Mydata);
+            ::CloseHandle(_Mymapping);
+            _Mymapping = nullptr;
+        }
+
+        _Mydata = nullptr;
+        _Mysize = 0;
+        _Mybuf.reset();
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,54 @@
+// mapped_file.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_MAPPED_FILE_HPP_
+#define _ULPCL_MAPPED_FILE_HPP_
+#include <cstddef>
+#include <mjfs/file.hpp>
+#include <mjmem/smart_pointer.hpp>
+#include <mjstr/string_view.hpp>
+
+namespace mjx {
+    class mapped_file { // read-only view of the whole file contents
+    public:
+        mapped_file() noexcept;
+        mapped_file(mapped_file&& _Other) noexcept;
+        ~mapped_file() noexcept;
+
+        explicit mapped_file(file& _File);
+
+        mapped_file& operator=(mapped_file&& _Other) noexcept;
+
+        mapped_file(const mapped_file&)            = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        // checks if the file contents are available
+        bool is_open() const noexcept;
+
+        // checks if the file contents are mapped into memory
+        bool is_mapped() const noexcept;
+
+        // returns the file contents
+        byte_string_view view() const noexcept;
+
+        // releases the file contents
+        void close() noexcept;
+
+    private:
+        // tries to map the whole file into memory
+        bool _Map(file& _File, const size_t _Size) noexcept;
+
+        // reads the whole file into the internal buffer
+        bool _Read(file& _File, const size_t _Size);
+
+        void* _Mymapping; // file mapping handle, null if the file is not mapped
+        const byte_t* _Mydata;
+        size_t _Mysize;
+        unique_smart_array<byte_t> _Mybuf; // used only if the file cannot be mapped
+    };
+} // namespace mjx
+
+#endif // _ULPCL_MAPPED_FILE_HPP_
\ No newline at end of file
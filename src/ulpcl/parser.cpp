@@ -3,30 +3,42 @@
 // Copyright (c) Mateusz Jandura. All rights reserved.
 // SPDX-License-Identifier: Apache-2.0
 
+#include <algorithm>
+#include <mjmem/exception.hpp>
 #include <mjstr/conversion.hpp>
 #include <ulpcl/logger.hpp>
 #include <ulpcl/parser.hpp>
 #include <ulpcl/program.hpp>
 #include <ulpcl/runtime.hpp>
+#include <xxhash/xxhash.h>
 
 namespace mjx {
-    size_t _Parser_base::_Remaining_tokens() const noexcept {
-        return _Stream.size() - _Off - 1;
+    bool _Parser_base::_Has_remaining_tokens(const size_t _Count) const {
+        return _Stream.has_token(_Off + _Count);
+    }
+
+    template <class... _Types>
+    void _Parser_base::_Report_error(const unicode_string_view _Fmt, const _Types&... _Args) const {
+        // Note: If the lexical analysis fails, the remaining tokens are unavailable and the parser
+        //       would report an error caused by the missing quote, which has been already reported.
+        if (!_Stream.failed()) {
+            ::mjx::_Report_error(_Counters, _Fmt, _Args...);
+        }
     }
 
     bool _Parser_base::_Is_matching_keyword(const token& _Token, const keyword _Keyword) const noexcept {
-        return _Token.type == token_type::keyword && parse_keyword(_Token.data) == _Keyword;
+        return _Token.type == token_type::keyword && _Token.kw == _Keyword;
     }
 
-    const token& _Parser_base::_Get_current_token() const {
+    token _Parser_base::_Get_current_token() const {
         return _Stream.get_token(_Off);
     }
 
-    const token& _Parser_base::_Get_current_token_and_advance() const {
+    token _Parser_base::_Get_current_token_and_advance() const {
         return _Stream.get_token(_Off++);
     }
 
-    const token& _Parser_base::_Get_next_token() const {
+    token _Parser_base::_Get_next_token() const {
         return _Stream.get_token(++_Off);
     }
 
@@ -49,9 +61,9 @@ namespace mjx {
     }
 
     bool _Static_parser::_Parse_language() {
-        if (_Remaining_tokens() < 3) { // language name consists of three tokens
-            const token_location _Location = _Get_current_token().location;
-            _Report_error(_Counters, L"(%u, %u): error E2000: undefined symbol '@language' which is required",
+        if (!_Has_remaining_tokens(3)) { // language name consists of three tokens
+            const token_location _Location = _Stream.locate(_Get_current_token().position);
+            _Report_error(L"(%u, %u): error E2000: undefined symbol '@language' which is required",
                 _Location.line, _Location.column);
             return false;
         }
@@ -59,27 +71,29 @@ namespace mjx {
         // expected token order: '@language', ':' and '<string-literal>'
         const token& _First = _Get_current_token_and_advance();
         if (!_Is_matching_keyword(_First, keyword::language)) {
-            _Report_error(_Counters, L"(%u, %u): error E2000: undefined symbol '@language' which is required",
-                _First.location.line, _First.location.column);
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2000: undefined symbol '@language' which is required",
+                _Location.line, _Location.column);
             return false;
         }
 
         const token& _Second = _Get_current_token_and_advance();
         const token& _Third  = _Get_current_token_and_advance();
         if (_Second.type != token_type::colon || _Third.type != token_type::string_literal) {
-            _Report_error(_Counters, L"(%u, %u): error E2006: invalid usage of the '@language' keyword",
-                _First.location.line, _First.location.column);
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2006: invalid usage of the '@language' keyword",
+                _Location.line, _Location.column);
             return false;
         }
 
-        _Tree.language = ::mjx::to_unicode_string(_Third.data);
+        _Tree.language = ::mjx::to_unicode_string(_Stream.data(_Third));
         return true;
     }
 
     bool _Static_parser::_Parse_lcid() {
-        if (_Remaining_tokens() < 3) { // LCID consists of three tokens
-            const token_location _Location = _Get_current_token().location;
-            _Report_error(_Counters, L"(%u, %u): error E2000: undefined symbol '@lcid' which is required",
+        if (!_Has_remaining_tokens(3)) { // LCID consists of three tokens
+            const token_location _Location = _Stream.locate(_Get_current_token().position);
+            _Report_error(L"(%u, %u): error E2000: undefined symbol '@lcid' which is required",
                 _Location.line, _Location.column);
             return false;
         }
@@ -87,40 +101,43 @@ namespace mjx {
         // expected token order: '@lcid', ':' and '<string-literal>'
         const token& _First = _Get_current_token_and_advance();
         if (!_Is_matching_keyword(_First, keyword::lcid)) {
-            _Report_error(_Counters, L"(%u, %u): error E2000: undefined symbol '@lcid' which is required",
-                _First.location.line, _First.location.column);
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2000: undefined symbol '@lcid' which is required",
+                _Location.line, _Location.column);
             return false;
         }
 
         const token& _Second = _Get_current_token_and_advance();
         const token& _Third  = _Get_current_token_and_advance();
         if (_Second.type != token_type::colon || _Third.type != token_type::string_literal) {
-            _Report_error(_Counters, L"(%u, %u): error E2006: invalid usage of the '@lcid' keyword",
-                _First.location.line, _First.location.column);
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2006: invalid usage of the '@lcid' keyword",
+                _Location.line, _Location.column);
             return false;
         }
 
-        _Tree.lcid = _Lcid_parser::_Parse(_Third.data);
+        _Tree.lcid = _Lcid_parser::_Parse(_Stream.data(_Third));
         if (_Tree.lcid == _Lcid_parser::_Invalid) { // invalid LCID, break
-            _Report_error(_Counters, L"(%u, %u): error E2011: invalid '@lcid' value",
-                _Third.location.line, _Third.location.column);
+            const token_location _Location = _Stream.locate(_Third.position);
+            _Report_error(L"(%u, %u): error E2011: invalid '@lcid' value",
+                _Location.line, _Location.column);
             return false;
         }
 
         return true;
     }
 
-    bool _Static_parser::_Skip_meta() noexcept {
+    bool _Static_parser::_Skip_meta() {
         // expected token order: '@meta', '{', ..., '}'; note that '@meta' is already skipped
-        const token_location _Location = _Get_current_token_and_advance().location; // capture '@meta' location
+        const uint32_t _Position = _Get_current_token_and_advance().position; // capture '@meta' position
         if (_Get_current_token_and_advance().type != token_type::left_curly_bracket) {
-            _Report_error(_Counters, L"(%u, %u): error E2003: missing opening bracket '{' for group '@meta'",
+            const token_location _Location = _Stream.locate(_Position);
+            _Report_error(L"(%u, %u): error E2003: missing opening bracket '{' for group '@meta'",
                 _Location.line, _Location.column);
             return false;
         }
 
-        const size_t _Max_off = _Stream.size() - 1; // omit the last token (already checked)
-        while (_Off < _Max_off) { // search for the right curly bracket
+        while (_Has_remaining_tokens(1)) { // search for the right curly bracket, omit the last token
             const token& _Token = _Get_current_token_and_advance();
             if (_Is_matching_keyword(_Token, keyword::content)) {
                 // '@content' cannot appear before the '@meta' closing bracket
@@ -130,15 +147,16 @@ namespace mjx {
             }
         }
 
-        _Report_error(_Counters, L"(%u, %u): error E2004: missing closing bracket '}' for group '@meta'",
+        const token_location _Location = _Stream.locate(_Position);
+        _Report_error(L"(%u, %u): error E2004: missing closing bracket '}' for group '@meta'",
             _Location.line, _Location.column);
         return false;
     }
 
-    bool _Static_parser::_Validate_content() noexcept {
-        if (_Remaining_tokens() < 3) { // content consists of at least three tokens
-            const token_location _Location = _Get_current_token().location;
-            _Report_error(_Counters, L"(%u, %u): error E2000: undefined symbol '@language' which is required",
+    bool _Static_parser::_Validate_content() {
+        if (!_Has_remaining_tokens(3)) { // content consists of at least three tokens
+            const token_location _Location = _Stream.locate(_Get_current_token().position);
+            _Report_error(L"(%u, %u): error E2000: undefined symbol '@language' which is required",
                 _Location.line, _Location.column);
             return false;
         }
@@ -146,23 +164,20 @@ namespace mjx {
         // expected token order: '@content', '{', ..., '}'
         const token& _First = _Get_current_token_and_advance();
         if (!_Is_matching_keyword(_First, keyword::content)) {
-            _Report_error(_Counters, L"(%u, %u): error E2000: undefined symbol '@content' which is required",
-                _First.location.line, _First.location.column);
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2000: undefined symbol '@content' which is required",
+                _Location.line, _Location.column);
             return false;
         }
 
         if (_Get_current_token_and_advance().type != token_type::left_curly_bracket) {
-            _Report_error(_Counters, L"(%u, %u): error E2003: missing opening bracket '{' for group '@content'",
-                _First.location.line, _First.location.column);
-            return false;
-        }
-
-        if (_Stream.get_token(_Stream.size() - 2).type != token_type::right_curly_bracket) {
-            _Report_error(_Counters, L"(%u, %u): error E2004: missing closing bracket '}' for group '@content'",
-                _First.location.line, _First.location.column);
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2003: missing opening bracket '{' for group '@content'",
+                _Location.line, _Location.column);
             return false;
         }
 
+        _Content_position = _First.position; // the closing bracket is validated after dynamic tokens
         return true;
     }
 
@@ -171,14 +186,15 @@ namespace mjx {
             return false;
         }
 
-        if (_Remaining_tokens() < 2) {
+        if (!_Has_remaining_tokens(2)) {
             const token& _Token = _Get_current_token();
             if (_Token.type != token_type::left_curly_bracket) { // left curly bracket missing
-                _Report_error(_Counters, L"(%u, %u): error E2001: missing opening bracket '{' for the global section",
-                    _Token.location.line, _Token.location.column);
+                const token_location _Location = _Stream.locate(_Token.position);
+                _Report_error(L"(%u, %u): error E2001: missing opening bracket '{' for the global section",
+                    _Location.line, _Location.column);
             } else { // right curly bracket missing
-                const token_location _Location = _Stream.get_token(_Stream.size() - 1).location;
-                _Report_error(_Counters, L"(%u, %u): error E2002: missing closing bracket '}' for the global section",
+                const token_location _Location = _Stream.locate(_Stream.get_token(_Stream.size() - 1).position);
+                _Report_error(L"(%u, %u): error E2002: missing closing bracket '}' for the global section",
                     _Location.line, _Location.column);
             }
 
@@ -188,28 +204,44 @@ namespace mjx {
         { // check if left curly bracket is present
             const token& _Token = _Get_current_token_and_advance();
             if (_Token.type != token_type::left_curly_bracket) {
-                _Report_error(_Counters, L"(%u, %u): error E2001: missing opening bracket '{' for the global section",
-                    _Token.location.line, _Token.location.column);
+                const token_location _Location = _Stream.locate(_Token.position);
+                _Report_error(L"(%u, %u): error E2001: missing opening bracket '{' for the global section",
+                    _Location.line, _Location.column);
                 return false;
             }
         }
 
-        { // check if right curly bracket is present
-            const token& _Token = _Stream.get_token(_Stream.size() - 1); // should be as the last token
-            if (_Token.type != token_type::right_curly_bracket) {
-                _Report_error(_Counters, L"(%u, %u): error E2002: missing closing bracket '}' for the global section",
-                    _Token.location.line, _Token.location.column);
+        if (_Has_remaining_tokens(1) && _Is_matching_keyword(_Get_current_token(), keyword::meta)) { // skip metadata
+            if (!_Skip_meta()) { // something went wrong, break
                 return false;
             }
         }
 
-        if (_Remaining_tokens() > 0 && _Is_matching_keyword(_Get_current_token(), keyword::meta)) { // skip metadata
-            if (!_Skip_meta()) { // something went wrong, break
+        return _Validate_content();
+    }
+
+    bool _Static_parser::_Validate_closing_brackets() {
+        // Note: The tokens are analyzed while they are parsed, so the last two tokens are available
+        //       only after all dynamic tokens have been parsed. Until then, the dynamic parser omits them.
+        const size_t _Size = _Stream.size();
+        { // check if right curly bracket is present
+            const token& _Token = _Stream.get_token(_Size - 1); // should be as the last token
+            if (_Token.type != token_type::right_curly_bracket) {
+                const token_location _Location = _Stream.locate(_Token.position);
+                _Report_error(L"(%u, %u): error E2002: missing closing bracket '}' for the global section",
+                    _Location.line, _Location.column);
                 return false;
             }
         }
 
-        return _Validate_content();
+        if (_Stream.get_token(_Size - 2).type != token_type::right_curly_bracket) {
+            const token_location _Location = _Stream.locate(_Content_position);
+            _Report_error(L"(%u, %u): error E2004: missing closing bracket '}' for group '@content'",
+                _Location.line, _Location.column);
+            return false;
+        }
+
+        return true;
     }
 
     bool _Name_validator::_Is_valid_char(const byte_t _Ch) noexcept {
@@ -244,126 +276,245 @@ namespace mjx {
         return true;
     }
 
-    bool _Name_validator::_Is_identifier_name_unique(
-        const vector<message>& _Messages, const utf8_string_view _Name) noexcept {
-        // check if _Name is unique within the scope of _Messages
-        for (const message& _Message : _Messages) {
-            if (_Message.id == _Name) { // same name found, break
-                return false;
+    _Name_set::_Name_set() noexcept : _Myslots(), _Mysize(0) {}
+
+    _Name_set::~_Name_set() noexcept {}
+
+    void _Name_set::_Grow() {
+        const size_t _New_size = _Myslots.empty() ? _Min_capacity : _Myslots.size() * 2;
+        const size_t _Mask     = _New_size - 1;
+        vector<_Slot> _New_slots(_New_size);
+        for (const _Slot& _Old_slot : _Myslots) {
+            if (_Old_slot._Index == 0) { // empty slot, skip it
+                continue;
             }
+
+            size_t _Idx = static_cast<size_t>(_Old_slot._Hash) & _Mask;
+            while (_New_slots[_Idx]._Index != 0) { // find the first empty slot
+                _Idx = (_Idx + 1) & _Mask;
+            }
+
+            _New_slots[_Idx] = _Old_slot;
         }
 
-        return true;
+        _Myslots = ::std::move(_New_slots);
     }
 
-    bool _Name_validator::_Is_group_name_unique(
-        const vector<group>& _Groups, const utf8_string_view _Name) noexcept {
-        // check if _Name is unique within the scope of _Groups
-        for (const group& _Group : _Groups) {
-            if (_Group.name == _Name) { // same name found, break
+    template <class _Ty>
+    bool _Name_set::_Insert_name(const arena_vector<_Ty>& _Elements,
+        utf8_string_view _Ty::* const _Member, const utf8_string_view _Name, const uint64_t _Hash) {
+        // Note: The set stores only the hashes of the names and the indexes of the elements that hold them,
+        //       as the names may be moved when the elements are reallocated. The names themselves are
+        //       compared only if their hashes are equal.
+        if ((_Mysize + 1) * 2 > _Myslots.size()) { // keep the load factor at most 50%
+            _Grow();
+        }
+
+        const size_t _Mask = _Myslots.size() - 1;
+        for (size_t _Idx = static_cast<size_t>(_Hash) & _Mask;; _Idx = (_Idx + 1) & _Mask) {
+            _Slot& _Current = _Myslots[_Idx];
+            if (_Current._Index == 0) { // empty slot found, the name is unique
+                _Current._Hash  = _Hash;
+                _Current._Index = static_cast<uint32_t>(_Elements.size()) + 1; // the element is appended next
+                ++_Mysize;
+                return true;
+            }
+
+            if (_Current._Hash == _Hash && _Elements[_Current._Index - 1].*_Member == _Name) { // same name found
                 return false;
             }
         }
-    
-        return true;
     }
 
-    template <class _Group_type>
-    bool _Dynamic_parser::_Append_group(_Group_type& _Group, const utf8_string_view _Name) {
-        if (!_Name_validator::_Is_group_name_unique(_Group.groups, _Name)) { // ambiguous name, break
-            return false;
+    bool _Name_set::_Insert(
+        const arena_vector<message>& _Messages, const utf8_string_view _Name, const uint64_t _Hash) {
+        return _Insert_name(_Messages, &message::id, _Name, _Hash);
+    }
+
+    bool _Name_set::_Insert(const arena_vector<group>& _Groups, const utf8_string_view _Name, const uint64_t _Hash) {
+        return _Insert_name(_Groups, &group::name, _Name, _Hash);
+    }
+
+    _Id_prefix::_Id_prefix() noexcept
+        : _Myprefix(), _Myname(), _Myroot(true), _Mybuf(), _Mystate(nullptr), _Myscratch(nullptr) {}
+
+    _Id_prefix::~_Id_prefix() noexcept {
+        ::XXH3_freeState(_Mystate);
+        ::XXH3_freeState(_Myscratch);
+    }
+
+    utf8_string_view _Id_prefix::_Get() const noexcept {
+        return _Myprefix;
+    }
+
+    utf8_string_view _Id_prefix::_Get_name() const noexcept {
+        return _Myname;
+    }
+
+    void _Id_prefix::_Assign(const _Id_prefix& _Parent, const byte_string_view _Name, arena& _Arena) {
+        // Note: Only the groups defined directly in the root group have no separator. The names of other
+        //       groups are always preceded by '.', even if the parent's name is empty (e.g. '.x').
+        const utf8_string_view _Parent_prefix = _Parent._Myprefix;
+        const size_t _Size = _Parent._Myroot ? _Name.size() : _Parent_prefix.size() + 1 + _Name.size();
+        char* const _Data  = static_cast<char*>(_Arena.allocate_aligned(_Size, alignof(char)));
+        char* _Own_part    = _Data; // the group's own name, preceded by '.' if the group is not a root's child
+        if (!_Parent._Myroot) { // separate the parent's name from the group's name
+            _Own_part  = ::std::copy_n(_Parent_prefix.data(), _Parent_prefix.size(), _Data);
+            *_Own_part = '.';
         }
 
-        _Group.groups.push_back(group{_Name});
-        return true;
+        ::std::copy_n(_Name.data(), _Name.size(), _Data + (_Size - _Name.size()));
+        _Myprefix = utf8_string_view{_Data, _Size};
+        _Myname   = _Myprefix.substr(_Size - _Name.size());
+        _Myroot   = false;
+        if (_Size <= _Max_buffered_size) { // short prefix, hash it along with each suffix
+            _Mybuf.assign(_Myprefix);
+            return;
+        }
+
+        _Mystate   = ::XXH3_createState();
+        _Myscratch = ::XXH3_createState();
+        if (!_Mystate || !_Myscratch) {
+            allocation_failure::raise();
+        }
+
+        if (_Parent._Mystate) { // continue from the parent's state, its prefix is not hashed again
+            ::XXH3_copyState(_Mystate, _Parent._Mystate);
+            ::XXH3_64bits_update(_Mystate, _Own_part, static_cast<size_t>(_Data + _Size - _Own_part));
+        } else { // hash the whole prefix
+            ::XXH3_64bits_reset(_Mystate);
+            ::XXH3_64bits_update(_Mystate, _Data, _Size);
+        }
     }
 
-    template <class _Group_type>
-    bool _Dynamic_parser::_Append_message(
-        _Group_type& _Group, const utf8_string_view _Id, const unicode_string_view _Value) {
-        if (!_Name_validator::_Is_identifier_name_unique(_Group.messages, _Id)) { // ambiguous name, break
+    uint64_t _Id_prefix::_Compute_hash(const utf8_string_view _Suffix) {
+        if (_Mystate) { // continue from the saved state
+            ::XXH3_copyState(_Myscratch, _Mystate);
+            ::XXH3_64bits_update(_Myscratch, _Suffix.data(), _Suffix.size());
+            return ::XXH3_64bits_digest(_Myscratch);
+        }
+
+        if (_Myprefix.empty()) { // no prefix, hash the suffix alone
+            return ::XXH3_64bits(_Suffix.data(), _Suffix.size());
+        }
+
+        _Mybuf.resize(_Myprefix.size()); // discard the previous suffix
+        _Mybuf.append(_Suffix);
+        return ::XXH3_64bits(_Mybuf.data(), _Mybuf.size());
+    }
+
+    uint32_t _Dynamic_parser::_Append_group(const uint32_t _Parent, _Name_scope& _Scope, _Id_prefix& _Prefix) {
+        // the qualified names of sibling groups differ only by their last parts
+        const utf8_string_view _Name = _Prefix._Get();
+        if (!_Scope._Groups._Insert(_Tree.groups, _Name, _Prefix._Compute_hash(utf8_string_view{}))) {
+            return _Invalid_group; // ambiguous name, break
+        }
+
+        _Tree.groups.push_back(group{_Name, _Parent});
+        ++_Tree.groups[_Parent].group_count;
+        return static_cast<uint32_t>(_Tree.groups.size() - 1);
+    }
+
+    bool _Dynamic_parser::_Append_message(const uint32_t _Group, _Name_scope& _Scope,
+        const utf8_string_view _Id, const byte_string_view _Value) {
+        const uint64_t _Hash = _Scope._Prefix._Compute_hash(_Id); // hash of the qualified ID
+        if (!_Scope._Messages._Insert(_Tree.messages, _Id, _Hash)) { // ambiguous name, break
             return false;
         }
 
-        _Group.messages.push_back(message{_Id, _Value});
+        _Tree.messages.push_back(message{_Id, _Value, _Group, _Hash});
+        ++_Tree.groups[_Group].message_count;
         return true;
     }
 
-    template <class _Group_type>
-    bool _Dynamic_parser::_Parse_group(_Group_type& _Group, const token_location _Location) {
-        if (_Remaining_tokens() < 4) { // group consists of at least five tokens (keyword already skipped)
-            _Report_error(_Counters, L"(%u, %u): error E2006: invalid usage of the '@group' keyword",
+    bool _Dynamic_parser::_Parse_group(const uint32_t _Parent, _Name_scope& _Scope, const uint32_t _Position) {
+        if (!_Has_remaining_tokens(4)) { // group consists of at least five tokens (keyword already skipped)
+            const token_location _Location = _Stream.locate(_Position);
+            _Report_error(L"(%u, %u): error E2006: invalid usage of the '@group' keyword",
                 _Location.line, _Location.column);
             return false;
         }
 
         // expected token order: '@group', ':', '<string-literal>', '{', ..., '}';
         // note that '@group' is already skipped
-        if (_Get_current_token_and_advance().type != token_type::colon) {
-            _Report_error(_Counters, L"(%u, %u): error E2006: invalid usage of the '@group' keyword",
+        constexpr token_type _Expected[] = {token_type::colon, token_type::string_literal};
+        if (!_Stream.matches(_Off, _Expected)) {
+            const token_location _Location = _Stream.locate(_Position);
+            _Report_error(L"(%u, %u): error E2006: invalid usage of the '@group' keyword",
                 _Location.line, _Location.column);
             return false;
         }
 
-        const token& _First = _Get_current_token_and_advance();
-        if (_First.type != token_type::string_literal) {
-            _Report_error(_Counters, L"(%u, %u): error E2006: invalid usage of the '@group' keyword",
-                _Location.line, _Location.column);
-            return false;
-        }
+        const token& _First = _Stream.get_token(_Off + 1);
+        _Off               += 2; // skip ':' and '<string-literal>'
 
-        if (!_Name_validator::_Is_valid_group_name(_First.data)) {
-            _Report_error(_Counters, L"(%u, %u): error E2009: illegal group name '%s'",
-                _First.location.line, _First.location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+        const byte_string_view _Name = _Stream.data(_First);
+        if (!_Name_validator::_Is_valid_group_name(_Name)) {
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2009: illegal group name '%s'",
+                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Name).c_str());
             return false;
         }
 
+        // Note: The literal may be stored in the lexer's pool, which is reallocated when more tokens
+        //       are analyzed on demand (e.g. by the next token access), so the group's name is copied
+        //       into the arena first and accessed only through that copy from now on.
+        _Name_scope _Inner_scope; // names defined within the new group
+        _Inner_scope._Prefix._Assign(_Scope._Prefix, _Name, _Arena);
+        const utf8_string_view _Group_name = _Inner_scope._Prefix._Get_name();
         if (_Get_current_token_and_advance().type != token_type::left_curly_bracket) {
-            _Report_error(_Counters, L"(%u, %u): error E2003: missing opening bracket '{' for group '%s'",
-                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+            const token_location _Location = _Stream.locate(_Position);
+            _Report_error(L"(%u, %u): error E2003: missing opening bracket '{' for group '%s'",
+                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Group_name).c_str());
             return false;
         }
 
-        if (!_Append_group(_Group, ::mjx::to_utf8_string(_First.data))) { // failed to append the group, break
-            _Report_error(_Counters, L"(%u, %u): error E2007: ambiguous group name, '%s' is already defined",
-                _First.location.line, _First.location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+        const uint32_t _This_group = _Append_group(_Parent, _Scope, _Inner_scope._Prefix);
+        if (_This_group == _Invalid_group) { // failed to append the group, break
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2007: ambiguous group name, '%s' is already defined",
+                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Group_name).c_str());
             return false;
         }
 
-        const size_t _Max_off = _Stream.size() - 2; // omit the last two tokens (right curly brackets)
-        while (_Off < _Max_off) {
+        while (_Has_remaining_tokens(2)) { // omit the last two tokens (right curly brackets)
+            _Stream.release(_Off); // the preceding tokens won't be accessed anymore
             const token& _Token = _Get_current_token(); // don't advance
             switch (_Token.type) {
             case token_type::keyword: // parse a group
-                if (parse_keyword(_Token.data) != keyword::group) { // invalid keyword usage
-                    _Report_error(_Counters, L"(%u, %u): error E2006: invalid usage of the '%s' keyword",
-                        _Token.location.line, _Token.location.column, _Fast_str_cvt<wchar_t>(_Token.data).c_str());
+                if (_Token.kw != keyword::group) { // invalid keyword usage
+                    const token_location _Location = _Stream.locate(_Token.position);
+                    _Report_error(L"(%u, %u): error E2006: invalid usage of the '%s' keyword",
+                        _Location.line, _Location.column,
+                        _Fast_str_cvt<wchar_t>(_Stream.data(_Token)).c_str());
                     return false;
                 }
 
                 ++_Off; // skip '@group' keyword
-                if (!_Parse_group(_Group.groups.back(), _Token.location)) { // failed to parse the group
+                if (!_Parse_group(_This_group, _Inner_scope, _Token.position)) { // failed to parse the group
                     return false;
                 }
 
                 break;
             case token_type::identifier: // parse a message
-                if (!_Parse_message(_Group.groups.back())) { // failed to parse the message
+                if (!_Parse_message(_This_group, _Inner_scope)) { // failed to parse the message
                     return false;
                 }
 
                 break;
             case token_type::right_curly_bracket: // close the current group
             {
-                const group& _This_group = _Group.groups.back();
-                if (_This_group.messages.empty() && _This_group.groups.empty()) {
+                const group& _Group = _Tree.groups[_This_group];
+                if (_Group.message_count == 0 && _Group.group_count == 0) {
                     if (program_options::current().model == error_model::strict) { // report an error
-                        _Report_error(_Counters, L"(%u, %u): error E2015: group '%s' has no members",
-                            _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+                        const token_location _Location = _Stream.locate(_Position);
+                        _Report_error(L"(%u, %u): error E2015: group '%s' has no members",
+                            _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Group_name).c_str());
                         return false;
                     } else { // report a warning
+                        const token_location _Location = _Stream.locate(_Position);
                         _Report_warning(_Counters, L"(%u, %u): warning W2002: group '%s' has no members",
-                            _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+                            _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Group_name).c_str());
                     }
                 }
 
@@ -371,143 +522,205 @@ namespace mjx {
                 return true;
             }
             default:
-                _Report_error(_Counters, L"(%u, %u): error E2012: unexpected token '%s'",
-                    _Token.location.line, _Token.location.column, _Fast_str_cvt<wchar_t>(_Token.data).c_str());
+                const token_location _Location = _Stream.locate(_Token.position);
+                _Report_error(L"(%u, %u): error E2012: unexpected token '%s'",
+                    _Location.line, _Location.column,
+                    _Fast_str_cvt<wchar_t>(_Stream.data(_Token)).c_str());
                 return false;
             }
         }
 
-        _Report_error(_Counters, L"(%u, %u): error E2004: missing closing bracket '}' for group '%s'",
-            _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+        const token_location _Location = _Stream.locate(_Position);
+        _Report_error(L"(%u, %u): error E2004: missing closing bracket '}' for group '%s'",
+            _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Group_name).c_str());
         return false;
     }
 
-    template <class _Group_type>
-    bool _Dynamic_parser::_Parse_message(_Group_type& _Group) {
-        if (_Remaining_tokens() < 3) { // message consists of three tokens
-            const token& _Token = _Get_current_token();
-            _Report_error(_Counters, L"(%u, %u): error E2005: incomplete message '%s'",
-                _Token.location.line, _Token.location.column, _Fast_str_cvt<wchar_t>(_Token.data).c_str());
+    bool _Dynamic_parser::_Parse_message(const uint32_t _Group, _Name_scope& _Scope) {
+        if (!_Has_remaining_tokens(3)) { // message consists of three tokens
+            const token& _Token            = _Get_current_token();
+            const token_location _Location = _Stream.locate(_Token.position);
+            _Report_error(L"(%u, %u): error E2005: incomplete message '%s'",
+                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Stream.data(_Token)).c_str());
             return false;
         }
 
         // expected token order: '#<id>', ':' and '<value>'
-        const token& _First = _Get_current_token_and_advance();
-        if (!_Name_validator::_Is_valid_identifier_name(_First.data)) { // illegal identifier, break
-            _Report_error(_Counters, L"(%u, %u): error E2010: illegal identifier name '%s'",
-                _First.location.line, _First.location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+        const token& _First              = _Get_current_token();
+        const byte_string_view _Token_id = _Stream.data(_First);
+        if (!_Name_validator::_Is_valid_identifier_name(_Token_id)) { // illegal identifier, break
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2010: illegal identifier name '%s'",
+                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Token_id).c_str());
             return false;
         }
 
-        const token& _Second = _Get_current_token_and_advance();
-        const token& _Third  = _Get_current_token_and_advance();
-        if (_Second.type != token_type::colon || _Third.type != token_type::string_literal) {
-            _Report_error(_Counters, L"(%u, %u): error E2005: incomplete message '%s'",
-                _First.location.line, _First.location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+        // Note: The identifier may be stored in the lexer's pool, which is reallocated when more tokens
+        //       are analyzed on demand, so it is copied into the arena before the following tokens are accessed.
+        const utf8_string_view _Id = _Arena.copy_string<char>(_Token_id);
+
+        constexpr token_type _Expected[] = {token_type::identifier, token_type::colon, token_type::string_literal};
+        if (!_Stream.matches(_Off, _Expected)) {
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2005: incomplete message '%s'",
+                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Id).c_str());
             return false;
         }
 
+        const token& _Third = _Stream.get_token(_Off + 2);
+        _Off               += 3; // skip '#<id>', ':' and '<value>'
+
         // Note: Due to support for multi-line messages, we must scan for consecutive string literals,
-        //       each representing a single line of the message.
-        const size_t _Max_off = _Stream.size() - 2;
-        byte_string _Value    = _Third.data;
-        while (_Off < _Max_off) {
-            const token& _Token = _Get_current_token(); // don't advance
-            if (_Token.type != token_type::string_literal) {
-                break;
-            }
+        //       each representing a single line of the message. All of them are located at once,
+        //       so the lines can be joined directly in the arena, which owns the value.
+        const size_t _End_off              = _Off + _Stream.count_consecutive(_Off, token_type::string_literal);
+        const byte_string_view _First_line = _Stream.data(_Third);
+        size_t _Size                       = _First_line.size();
+        for (size_t _Idx = _Off; _Idx < _End_off; ++_Idx) {
+            _Size += 1 + _Stream.data(_Stream.get_token(_Idx)).size(); // '\n' and the line
+        }
 
-            _Value.push_back('\n');
-            _Value.append(_Token.data);
-            ++_Off; // advance to the next token
+        byte_t* const _Data = static_cast<byte_t*>(_Arena.allocate_aligned(_Size, alignof(byte_t)));
+        byte_t* _Next       = ::std::copy_n(_First_line.data(), _First_line.size(), _Data);
+        for (; _Off < _End_off; ++_Off) {
+            const byte_string_view _Line = _Stream.data(_Stream.get_token(_Off));
+            *_Next                       = '\n';
+            _Next                        = ::std::copy_n(_Line.data(), _Line.size(), _Next + 1);
         }
 
+        const byte_string_view _Value{_Data, _Size}; // UTF-8 encoded, no conversion is needed
+
         program_options& _Options = program_options::current();
         const bool _Empty         = _Value.empty();
         if (_Empty) { // empty message found
             if (_Options.model == error_model::strict) { // report error and break
-                _Report_error(_Counters, L"(%u, %u): error E2014: message '%s' has an empty value",
-                    _Third.location.line, _Third.location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+                const token_location _Location = _Stream.locate(_Third.position);
+                _Report_error(L"(%u, %u): error E2014: message '%s' has an empty value",
+                    _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Id).c_str());
                 return false;
             }
 
+            const token_location _Location = _Stream.locate(_Third.position);
             _Report_warning(_Counters, L"(%u, %u): warning W2001: message '%s' has an empty value",
-                _Third.location.line, _Third.location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Id).c_str());
             if (_Options.discard_empty_messages) { // discard empty message
                 return true;
             }
         }
 
-        if (!_Append_message( // ambiguous name found, break
-            _Group, ::mjx::to_utf8_string(_First.data), _Empty ? L"" : ::mjx::to_unicode_string(_Value))) {
-            _Report_error(_Counters, L"(%u, %u): error E2008: ambiguous identifier name, '%s' is already defined",
-                _First.location.line, _First.location.column, _Fast_str_cvt<wchar_t>(_First.data).c_str());
+        if (!_Append_message(_Group, _Scope, _Id, _Value)) { // ambiguous name, break
+            const token_location _Location = _Stream.locate(_First.position);
+            _Report_error(L"(%u, %u): error E2008: ambiguous identifier name, '%s' is already defined",
+                _Location.line, _Location.column, _Fast_str_cvt<wchar_t>(_Id).c_str());
             return false;
         }
 
         return true;
     }
 
+    void _Dynamic_parser::_Order_messages() {
+        // Note: The messages are appended in the order in which they appear in the input, so the messages
+        //       of a group may be interleaved with the messages of its subgroups. Since the groups are
+        //       stored in pre-order, a stable counting sort by the group index puts the messages of each
+        //       group next to each other, in the same order in which the compiler emits them.
+        uint32_t _First = 0;
+        for (group& _Group : _Tree.groups) {
+            _Group.first_message = _First;
+            _First              += _Group.message_count;
+        }
+
+        const auto _Is_ordered = [](const message& _Left, const message& _Right) noexcept {
+            return _Left.group < _Right.group;
+        };
+        if (::std::is_sorted(_Tree.messages.begin(), _Tree.messages.end(), _Is_ordered)) { // already ordered
+            return;
+        }
+
+        vector<uint32_t> _Next(_Tree.groups.size()); // index at which the next message of each group is placed
+        for (size_t _Idx = 0; _Idx < _Tree.groups.size(); ++_Idx) {
+            _Next[_Idx] = _Tree.groups[_Idx].first_message;
+        }
+
+        arena_vector<message> _Ordered(_Tree.messages.size(), _Arena);
+        for (const message& _Message : _Tree.messages) {
+            _Ordered[_Next[_Message.group]++] = _Message;
+        }
+
+        _Tree.messages = ::std::move(_Ordered);
+    }
+
     bool _Dynamic_parser::_Parse() {
-        const size_t _Max_off = _Stream.size() - 2; // omit the last two tokens (right curly brackets)
-        while (_Off < _Max_off) {
+        _Name_scope _Scope; // names defined within the '@content' section
+        while (_Has_remaining_tokens(2)) { // omit the last two tokens (right curly brackets)
+            _Stream.release(_Off); // the preceding tokens won't be accessed anymore
             const token& _Token = _Get_current_token(); // don't advance
             switch (_Token.type) {
             case token_type::keyword:
-                if (parse_keyword(_Token.data) != keyword::group) {
+                if (_Token.kw != keyword::group) {
                     // in this context only the '@group' keyword is valid
-                    _Report_error(_Counters, L"(%u, %u): error E2006: invalid usage of the '%s' keyword",
-                        _Token.location.line, _Token.location.column, _Fast_str_cvt<wchar_t>(_Token.data).c_str());
+                    const token_location _Location = _Stream.locate(_Token.position);
+                    _Report_error(L"(%u, %u): error E2006: invalid usage of the '%s' keyword",
+                        _Location.line, _Location.column,
+                        _Fast_str_cvt<wchar_t>(_Stream.data(_Token)).c_str());
                     return false;
                 }
 
                 ++_Off; // omit '@group' keyword
-                if (!_Parse_group(_Tree.content, _Token.location)) { // failed to parse a group, break
+                if (!_Parse_group(parse_tree::root, _Scope, _Token.position)) { // failed to parse a group, break
                     return false;
                 }
 
                 break;
             case token_type::identifier: // parse a message
-                if (!_Parse_message(_Tree.content)) { // failed to parse a message, break
+                if (!_Parse_message(parse_tree::root, _Scope)) { // failed to parse a message, break
                     return false;
                 }
 
                 break;
             default:
-                _Report_error(_Counters, L"(%u, %u): error E2012: unexpected token '%s'",
-                    _Token.location.line, _Token.location.column, _Fast_str_cvt<wchar_t>(_Token.data).c_str());
+                const token_location _Location = _Stream.locate(_Token.position);
+                _Report_error(L"(%u, %u): error E2012: unexpected token '%s'",
+                    _Location.line, _Location.column,
+                    _Fast_str_cvt<wchar_t>(_Stream.data(_Token)).c_str());
                 return false;
             }
         }
 
+        _Order_messages();
         return true;
     }
 
     parse_result parse_token_stream(
-        const token_stream& _Stream, const unicode_string_view _Pack, report_counters& _Counters) {
+        token_reader& _Stream, const unicode_string_view _Pack, arena& _Arena, report_counters& _Counters) {
         clog(L"> Starting parse");
-        parse_tree _Tree;
+        parse_tree _Tree{unicode_string{}, 0, arena_vector<group>(_Arena), arena_vector<message>(_Arena)};
+        _Tree.groups.push_back(group{}); // '@content' section
         bool _Success        = true;
         const float _Elapsed = measure_invoke_duration(
             [&] {
                 size_t _Off = 0;
-                _Static_parser _Static{_Off, _Tree, _Stream, _Counters};
+                _Static_parser _Static{_Off, _Tree, _Stream, _Counters, _Arena};
                 if (!_Static._Parse()) { // could not parse static tokens, break
                     _Success = false;
                     return;
                 }
 
-                _Dynamic_parser _Dynamic{_Off, _Tree, _Stream, _Counters};
-                if (!_Dynamic._Parse()) { // could not parse dynamic tokens
+                _Dynamic_parser _Dynamic{_Off, _Tree, _Stream, _Counters, _Arena};
+                if (!_Dynamic._Parse() || !_Static._Validate_closing_brackets()) { // could not parse the rest
                     _Success = false;
                 }
             }
         );
+        if (_Stream.failed()) { // lexical analysis failed during parse, error already reported
+            _Success = false;
+        }
+
         if (!_Success) { // something went wrong, break
             return parse_result{false};
         }
 
-        if (_Tree.content.messages.empty() && _Tree.content.groups.empty()) {
+        const group& _Root = _Tree.groups[parse_tree::root];
+        if (_Root.message_count == 0 && _Root.group_count == 0) {
             if (program_options::current().model == error_model::strict) { // report an error
                 _Report_error(
                     _Counters, L"(?, ?): error E2013: pack '%s' has no messages or groups", _Pack.data());
@@ -519,6 +732,6 @@ namespace mjx {
         }
 
         clog(L"> Completed parse (took %.5fs)", _Elapsed);
-        return parse_result{true, _Tree};
+        return parse_result{true, ::std::move(_Tree)};
     }
 } // namespace mjx
\ No newline at end of file
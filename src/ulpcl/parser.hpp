@@ -9,31 +9,41 @@
 #include <cstdint>
 #include <mjstr/string.hpp>
 #include <mjstr/string_view.hpp>
+#include <ulpcl/arena.hpp>
 #include <ulpcl/keyword.hpp>
 #include <ulpcl/lexer.hpp>
 #include <ulpcl/utils.hpp>
+#include <xxhash/xxhash.h>
 
 namespace mjx {
+    // Note: The parse tree doesn't own its strings and arrays, they are allocated in the arena
+    //       that is passed to the parser and must outlive the tree. Groups are stored in a single
+    //       array in the order in which they appear in the input (pre-order), the first one being
+    //       the '@content' section. Messages are stored in another array, ordered by their groups,
+    //       so each group refers to a contiguous range of its own messages. The qualified ID
+    //       of a message consists of the qualified name of its group followed by its own ID.
     struct message {
-        utf8_string id;
-        unicode_string value;
+        utf8_string_view id; // ID within the group, e.g. '#message'
+        byte_string_view value; // UTF-8 encoded
+        uint32_t group = 0; // index of the group that contains the message
+        uint64_t hash  = 0; // hash of the qualified ID, e.g. 'outer.inner#message'
     };
 
     struct group {
-        utf8_string name;
-        vector<message> messages;
-        vector<group> groups;
-    };
-
-    struct root_group {
-        vector<message> messages;
-        vector<group> groups;
+        utf8_string_view name; // qualified name, e.g. 'outer.inner', empty for the root group
+        uint32_t parent        = 0; // index of the parent group, the root group is its own parent
+        uint32_t first_message = 0; // index of the first message of the group
+        uint32_t message_count = 0; // number of messages in the group (not including subgroups)
+        uint32_t group_count   = 0; // number of direct subgroups
     };
 
     struct parse_tree {
+        static constexpr uint32_t root = 0; // index of the '@content' section
+
         unicode_string language;
         uint32_t lcid = 0;
-        root_group content;
+        arena_vector<group> groups;
+        arena_vector<message> messages;
     };
 
     struct report_counters;
@@ -42,23 +52,28 @@ namespace mjx {
     public:
         size_t& _Off;
         parse_tree& _Tree;
-        const token_stream& _Stream;
+        token_reader& _Stream;
         report_counters& _Counters;
+        arena& _Arena;
 
-        // returns the number of remaining tokens
-        size_t _Remaining_tokens() const noexcept;
+        // checks if at least _Count tokens follow the current one, analyzes more input data if needed
+        bool _Has_remaining_tokens(const size_t _Count) const;
+
+        // reports an error, unless the lexical analysis failed and the error has been already reported
+        template <class... _Types>
+        void _Report_error(const unicode_string_view _Fmt, const _Types&... _Args) const;
 
         // checks if the token is the specified keyword
         bool _Is_matching_keyword(const token& _Token, const keyword _Keyword) const noexcept;
 
         // returns the current token
-        const token& _Get_current_token() const;
+        token _Get_current_token() const;
 
         // returns the current token and advances to the next one
-        const token& _Get_current_token_and_advance() const;
+        token _Get_current_token_and_advance() const;
 
         // returns the next token
-        const token& _Get_next_token() const;
+        token _Get_next_token() const;
     };
 
     struct _Lcid_parser {
@@ -71,9 +86,14 @@ namespace mjx {
 
     class _Static_parser : public _Parser_base {
     public:
+        uint32_t _Content_position = 0; // position of the '@content' keyword
+
         // parses static tokens
         bool _Parse();
 
+        // validates the closing brackets of '@content' and the global section, called after dynamic tokens
+        bool _Validate_closing_brackets();
+
     private:
         // parses '@language' directive
         bool _Parse_language();
@@ -82,10 +102,10 @@ namespace mjx {
         bool _Parse_lcid();
 
         // skips '@meta' section
-        bool _Skip_meta() noexcept;
+        bool _Skip_meta();
 
         // validates '@content' section
-        bool _Validate_content() noexcept;
+        bool _Validate_content();
     };
 
     struct _Name_validator {
@@ -95,39 +115,104 @@ namespace mjx {
         // checks if the specified group name is valid
         static bool _Is_valid_group_name(const byte_string_view _Name) noexcept;
 
-        // checks if the specified identifier is unique in _Messages
-        static bool _Is_identifier_name_unique(
-            const vector<message>& _Messages, const utf8_string_view _Name) noexcept;
-
-        // checks if the specified
-        static bool _Is_group_name_unique(const vector<group>& _Groups, const utf8_string_view _Name) noexcept;
-
     private:
         // checks if _Ch can be used to represent a name
         static bool _Is_valid_char(const byte_t _Ch) noexcept;
     };
 
+    class _Name_set { // open-addressing hash set of the names defined within a single group
+    public:
+        _Name_set() noexcept;
+        ~_Name_set() noexcept;
+
+        // inserts the name of the message that is about to be appended, returns false if it's already defined
+        bool _Insert(const arena_vector<message>& _Messages, const utf8_string_view _Name, const uint64_t _Hash);
+
+        // inserts the name of the group that is about to be appended, returns false if it's already defined
+        bool _Insert(const arena_vector<group>& _Groups, const utf8_string_view _Name, const uint64_t _Hash);
+
+    private:
+        struct _Slot {
+            uint64_t _Hash;
+            uint32_t _Index; // index of the element that holds the name plus one, zero if the slot is empty
+        };
+
+        static constexpr size_t _Min_capacity = 16;
+
+        // doubles the number of slots and re-inserts the already inserted names
+        void _Grow();
+
+        template <class _Ty>
+        bool _Insert_name(const arena_vector<_Ty>& _Elements,
+            utf8_string_view _Ty::* const _Member, const utf8_string_view _Name, const uint64_t _Hash);
+
+        vector<_Slot> _Myslots;
+        size_t _Mysize;
+    };
+
+    class _Id_prefix { // qualified name of a group, shared by the qualified IDs of its members
+    public:
+        _Id_prefix() noexcept;
+        ~_Id_prefix() noexcept;
+
+        _Id_prefix(const _Id_prefix&)            = delete;
+        _Id_prefix& operator=(const _Id_prefix&) = delete;
+
+        // returns the qualified name of the group
+        utf8_string_view _Get() const noexcept;
+
+        // returns the group's own name (the last part of the qualified name)
+        utf8_string_view _Get_name() const noexcept;
+
+        // assigns the qualified name of a subgroup of _Parent
+        void _Assign(const _Id_prefix& _Parent, const byte_string_view _Name, arena& _Arena);
+
+        // computes the hash of the prefix followed by _Suffix
+        uint64_t _Compute_hash(const utf8_string_view _Suffix);
+
+    private:
+        // Note: XXH3 hashes inputs of up to 240 bytes at once, so its streaming state doesn't help
+        //       with shorter prefixes (the buffered bytes would be hashed again anyway). Such prefixes
+        //       are kept in a reusable buffer instead, and only the longer ones save their state.
+        static constexpr size_t _Max_buffered_size = 240;
+
+        utf8_string_view _Myprefix;
+        utf8_string_view _Myname; // the last part of the prefix
+        bool _Myroot; // true if this is the prefix of the root group (never assigned)
+        utf8_string _Mybuf; // the prefix followed by the last suffix, used only if there is no saved state
+        XXH3_state_t* _Mystate; // the state after hashing the prefix
+        XXH3_state_t* _Myscratch; // copy of the saved state that is updated with the suffix
+    };
+
+    struct _Name_scope { // names of the messages and groups defined within a single group
+        _Name_set _Messages;
+        _Name_set _Groups;
+        _Id_prefix _Prefix;
+    };
+
     class _Dynamic_parser : public _Parser_base {
     public:
         // parses dynamic tokens
         bool _Parse();
 
     private:
-        // appends a new group to the already existing group
-        template <class _Group_type>
-        bool _Append_group(_Group_type& _Group, const utf8_string_view _Name);
+        // appends a new group to the already existing group, returns its index or _Invalid_group
+        uint32_t _Append_group(const uint32_t _Parent, _Name_scope& _Scope, _Id_prefix& _Prefix);
 
         // appends a new message to the already existing group
-        template <class _Group_type>
-        bool _Append_message(_Group_type& _Group, const utf8_string_view _Id, const unicode_string_view _Value);
+        bool _Append_message(const uint32_t _Group, _Name_scope& _Scope,
+            const utf8_string_view _Id, const byte_string_view _Value);
 
         // parses a group
-        template <class _Group_type>
-        bool _Parse_group(_Group_type& _Group, const token_location _Location);
+        bool _Parse_group(const uint32_t _Parent, _Name_scope& _Scope, const uint32_t _Position);
 
         // parses a message
-        template <class _Group_type>
-        bool _Parse_message(_Group_type& _Group);
+        bool _Parse_message(const uint32_t _Group, _Name_scope& _Scope);
+
+        // orders the messages by their groups
+        void _Order_messages();
+
+        static constexpr uint32_t _Invalid_group = static_cast<uint32_t>(-1);
     };
 
     struct parse_result {
@@ -136,7 +221,7 @@ namespace mjx {
     };
 
     parse_result parse_token_stream(
-        const token_stream& _Stream, const unicode_string_view _Pack, report_counters& _Counters);
+        token_reader& _Stream, const unicode_string_view _Pack, arena& _Arena, report_counters& _Counters);
 } // namespace mjx
 
 #endif // _ULPCL_PARSER_HPP_
\ No newline at end of file
@@ -0,0 +1,143 @@
+// perfect_hash.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <ulpcl/perfect_hash.hpp>
+
+namespace mjx {
+    perfect_hash::perfect_hash() noexcept : _Myseed(0), _Mykeys(0), _Mypilots() {}
+
+    perfect_hash::~perfect_hash() noexcept {}
+
+    perfect_hash::_Build_result perfect_hash::_Try_build(const vector<uint64_t>& _Keys) {
+        // Note: The function is built in the PTHash manner. Each key is assigned to a bucket, then
+        //       the buckets are processed from the largest to the smallest. For each bucket, we search
+        //       for the smallest pilot that moves all its keys to free positions. Since the table
+        //       is minimal, the search becomes longer as the table fills up, so it is limited.
+        const uint32_t _Buckets   = static_cast<uint32_t>(_Mypilots.size());
+        const uint64_t _Max_pilot = (::std::min)(static_cast<uint64_t>(_Mykeys) * 32 + 1024, uint64_t{0xFFFF'FFFF});
+        vector<uint32_t> _Bucket_starts(static_cast<size_t>(_Buckets) + 1, 0);
+        vector<uint64_t> _Mixed_keys(_Mykeys);
+        for (const uint64_t _Key : _Keys) { // count the keys in each bucket
+            const uint64_t _Mixed = _Perfect_hash_traits::_Mix(_Key ^ _Myseed);
+            ++_Bucket_starts[_Perfect_hash_traits::_Bucket(_Mixed, _Buckets) + 1];
+        }
+
+        uint32_t _Max_size = 0;
+        for (uint32_t _Bucket = 0; _Bucket < _Buckets; ++_Bucket) {
+            _Max_size                    = (::std::max)(_Max_size, _Bucket_starts[_Bucket + 1]);
+            _Bucket_starts[_Bucket + 1] += _Bucket_starts[_Bucket];
+        }
+
+        vector<uint32_t> _Next(_Bucket_starts.begin(), _Bucket_starts.end() - 1);
+        for (const uint64_t _Key : _Keys) { // group the mixed keys by buckets
+            const uint64_t _Mixed = _Perfect_hash_traits::_Mix(_Key ^ _Myseed);
+            _Mixed_keys[_Next[_Perfect_hash_traits::_Bucket(_Mixed, _Buckets)]++] = _Mixed;
+        }
+
+        // order the buckets by size (descending), buckets of equal size are ordered by index
+        const auto _Bucket_size = [&_Bucket_starts](const uint32_t _Bucket) noexcept {
+            return _Bucket_starts[_Bucket + 1] - _Bucket_starts[_Bucket];
+        };
+        vector<uint32_t> _Size_starts(static_cast<size_t>(_Max_size) + 2, 0);
+        for (uint32_t _Bucket = 0; _Bucket < _Buckets; ++_Bucket) {
+            ++_Size_starts[_Max_size - _Bucket_size(_Bucket) + 1];
+        }
+
+        for (uint32_t _Size = 0; _Size <= _Max_size; ++_Size) {
+            _Size_starts[_Size + 1] += _Size_starts[_Size];
+        }
+
+        vector<uint32_t> _Ordered_buckets(_Buckets);
+        for (uint32_t _Bucket = 0; _Bucket < _Buckets; ++_Bucket) {
+            _Ordered_buckets[_Size_starts[_Max_size - _Bucket_size(_Bucket)]++] = _Bucket;
+        }
+
+        vector<uint64_t> _Taken((static_cast<size_t>(_Mykeys) + 63) / 64, 0); // bitmap of the taken positions
+        vector<uint32_t> _Positions(_Max_size);
+        for (const uint32_t _Bucket : _Ordered_buckets) {
+            const uint64_t* const _First = _Mixed_keys.data() + _Bucket_starts[_Bucket];
+            const uint32_t _Size         = _Bucket_size(_Bucket);
+            if (_Size == 0) { // the remaining buckets are empty, break
+                break;
+            }
+
+            for (uint32_t _Idx = 1; _Idx < _Size; ++_Idx) { // equal keys cannot be separated by any pilot
+                for (uint32_t _Prev = 0; _Prev < _Idx; ++_Prev) {
+                    if (_First[_Idx] == _First[_Prev]) { // duplicate keys, break
+                        return _Build_result::_Duplicate_keys;
+                    }
+                }
+            }
+
+            uint64_t _Pilot = 0;
+            for (;; ++_Pilot) {
+                if (_Pilot > _Max_pilot) { // no pilot found, try another seed
+                    return _Build_result::_Retry;
+                }
+
+                uint32_t _Placed = 0;
+                for (; _Placed < _Size; ++_Placed) {
+                    const uint32_t _Pos = _Perfect_hash_traits::_Position(
+                        _First[_Placed], static_cast<uint32_t>(_Pilot), _Mykeys);
+                    if (_Taken[_Pos / 64] & (uint64_t{1} << (_Pos % 64))) { // position already taken, break
+                        break;
+                    }
+
+                    _Taken[_Pos / 64]   |= uint64_t{1} << (_Pos % 64); // take temporarily
+                    _Positions[_Placed]  = _Pos;
+                }
+
+                if (_Placed == _Size) { // all keys placed, break
+                    break;
+                }
+
+                for (uint32_t _Idx = 0; _Idx < _Placed; ++_Idx) { // release temporarily taken positions
+                    _Taken[_Positions[_Idx] / 64] &= ~(uint64_t{1} << (_Positions[_Idx] % 64));
+                }
+            }
+
+            _Mypilots[_Bucket] = static_cast<uint32_t>(_Pilot);
+        }
+
+        return _Build_result::_Success;
+    }
+
+    bool perfect_hash::build(const vector<uint64_t>& _Keys) {
+        constexpr uint64_t _Max_attempts = 16;
+        _Mykeys                          = static_cast<uint32_t>(_Keys.size());
+        for (uint64_t _Attempt = 0; _Attempt < _Max_attempts; ++_Attempt) {
+            // Note: The seeds are derived from the attempt number, so that the function is deterministic.
+            _Myseed = _Perfect_hash_traits::_Mix(_Attempt);
+            _Mypilots.assign(_Perfect_hash_traits::_Bucket_count(_Mykeys), 0);
+            switch (_Try_build(_Keys)) {
+            case _Build_result::_Success:
+                return true;
+            case _Build_result::_Duplicate_keys:
+                _Mypilots.clear();
+                return false;
+            default:
+                break;
+            }
+        }
+
+        _Mypilots.clear();
+        return false;
+    }
+
+    uint64_t perfect_hash::seed() const noexcept {
+        return _Myseed;
+    }
+
+    const vector<uint32_t>& perfect_hash::pilots() const noexcept {
+        return _Mypilots;
+    }
+
+    uint32_t perfect_hash::position(const uint64_t _Key) const noexcept {
+        const uint64_t _Mixed  = _Perfect_hash_traits::_Mix(_Key ^ _Myseed);
+        const uint32_t _Bucket = _Perfect_hash_traits::_Bucket(_Mixed, static_cast<uint32_t>(_Mypilots.size()));
+        return _Perfect_hash_traits::_Position(_Mixed, _Mypilots[_Bucket], _Mykeys);
+    }
+} // namespace mjx
\ No newline at end of file
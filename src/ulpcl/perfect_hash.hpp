@@ -0,0 +1,82 @@
+// perfect_hash.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_PERFECT_HASH_HPP_
+#define _ULPCL_PERFECT_HASH_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <ulpcl/utils.hpp>
+
+namespace mjx {
+    struct _Perfect_hash_traits { // functions shared by the builder and the readers
+        static constexpr size_t _Bucket_size = 4; // the average number of keys per bucket
+
+        // mixes the bits of a 64-bit value (SplitMix64 finalizer)
+        static constexpr uint64_t _Mix(uint64_t _Value) noexcept {
+            _Value ^= _Value >> 30;
+            _Value *= 0xBF58476D1CE4E5B9;
+            _Value ^= _Value >> 27;
+            _Value *= 0x94D049BB133111EB;
+            _Value ^= _Value >> 31;
+            return _Value;
+        }
+
+        // maps the high 32 bits of a 64-bit value onto the range [0, _Count)
+        static constexpr uint32_t _Reduce(const uint64_t _Value, const uint32_t _Count) noexcept {
+            return static_cast<uint32_t>(((_Value >> 32) * _Count) >> 32);
+        }
+
+        // returns the number of buckets for the specified number of keys
+        static constexpr uint32_t _Bucket_count(const uint32_t _Keys) noexcept {
+            return static_cast<uint32_t>((_Keys + _Bucket_size - 1) / _Bucket_size);
+        }
+
+        // returns the bucket of the mixed key
+        static constexpr uint32_t _Bucket(const uint64_t _Mixed_key, const uint32_t _Buckets) noexcept {
+            return _Reduce(_Mixed_key, _Buckets);
+        }
+
+        // returns the position of the mixed key displaced by the pilot
+        static constexpr uint32_t _Position(
+            const uint64_t _Mixed_key, const uint32_t _Pilot, const uint32_t _Keys) noexcept {
+            return _Reduce(_Mix(_Mixed_key ^ _Mix(_Pilot)), _Keys);
+        }
+    };
+
+    class perfect_hash { // minimal perfect hash function over distinct 64-bit hashes
+    public:
+        perfect_hash() noexcept;
+        ~perfect_hash() noexcept;
+
+        // builds the function over the keys, fails if the keys are not distinct
+        bool build(const vector<uint64_t>& _Keys);
+
+        // returns the seed the keys are mixed with
+        uint64_t seed() const noexcept;
+
+        // returns the pilots, one for each bucket
+        const vector<uint32_t>& pilots() const noexcept;
+
+        // returns the position of the key, meaningful only for the keys the function was built over
+        uint32_t position(const uint64_t _Key) const noexcept;
+
+    private:
+        enum class _Build_result : unsigned char {
+            _Success,
+            _Retry,
+            _Duplicate_keys
+        };
+
+        // tries to build the function with the current seed
+        _Build_result _Try_build(const vector<uint64_t>& _Keys);
+
+        uint64_t _Myseed;
+        uint32_t _Mykeys;
+        vector<uint32_t> _Mypilots;
+    };
+} // namespace mjx
+
+#endif // _ULPCL_PERFECT_HASH_HPP_
\ No newline at end of file
@@ -185,6 +185,23 @@ namespace mjx {
         }
     }
 
+    void _Options_parser::_Parse_compression(const unicode_string_view _Value) noexcept {
+        compression_mode& _Mode = program_options::current().compression;
+        if (_Mode == compression_mode::unknown) { // set the compression mode
+            if (_Value == L"none" || _Value == L"default") {
+                _Mode = compression_mode::none;
+            } else if (_Value == L"fsst") {
+                _Mode = compression_mode::fsst;
+            } else if (_Value == L"lz") {
+                _Mode = compression_mode::lz;
+            } else {
+                rtlog(L"Warning: Unsupported compression mode, ignored.");
+            }
+        } else { // the compression mode already specified
+            rtlog(L"Warning: Compression mode specified more than once, ignored.");
+        }
+    }
+
     void parse_program_args(int _Count, wchar_t** _Args) {
         program_options& _Options = program_options::current();
         bool _Verbose             = false;
@@ -198,6 +215,18 @@ namespace mjx {
                     _Options.discard_empty_messages = true;
                 } else if (_Arg == L"--symbol-file" || _Arg == L"-s") { // generate symbol file
                     _Options.generate_symbol_file = true;
+                } else if (_Arg == L"--hash-header") { // generate header with message ID hashes
+                    _Options.generate_hash_header = true;
+                } else if (_Arg == L"--sort-lookup-table") { // sort the lookup table by hashes
+                    _Options.sort_lookup_table = true;
+                } else if (_Arg == L"--perfect-hash-index") { // index the lookup table with a perfect hash
+                    _Options.perfect_hash_index = true;
+                } else if (_Arg == L"--merge-tails") { // store values within values they are tails of
+                    _Options.merge_tails = true;
+                } else if (_Arg == L"--aligned-layout") { // align sections for memory-mapped access
+                    _Options.aligned_layout = true;
+                } else if (_Arg == L"--ordinal-ids") { // index values by ordinals shared by all packs
+                    _Options.ordinal_ids = true;
                 } else if (_Arg == L"--verbose" || _Arg == L"-V") { // enable detailed logging
                     _Verbose = true;
                 } else { // unrecognized option
@@ -221,6 +250,8 @@ namespace mjx {
                     _Options_parser::_Parse_threads(_Value);
                 } else if (_Option == L"--error-model") { // set the error model
                     _Options_parser::_Parse_error_model(_Value);
+                } else if (_Option == L"--compression") { // set the compression mode
+                    _Options_parser::_Parse_compression(_Value);
                 } else {
                     rtlog(L"Warning: Unrecognized option '%s', ignored.", _Arg.data());
                 }
@@ -241,6 +272,20 @@ namespace mjx {
             _Options.model = error_model::soft;
         }
 
+        if (_Options.compression == compression_mode::unknown) { // set the default compression mode
+            _Options.compression = compression_mode::none;
+        }
+
+        if (_Options.compression == compression_mode::fsst && _Options.merge_tails) { // tails are not kept
+            rtlog(L"Warning: Compressed values cannot share their tails, tail merging ignored.");
+            _Options.merge_tails = false;
+        }
+
+        if (_Options.perfect_hash_index && _Options.sort_lookup_table) { // the lookup table has one order
+            rtlog(L"Warning: The lookup table cannot be both sorted and indexed, sorting ignored.");
+            _Options.sort_lookup_table = false;
+        }
+
         if (_Verbose) { // startup compilation logger
             compilation_logger::current().startup();
         }
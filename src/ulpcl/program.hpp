@@ -18,6 +18,13 @@ namespace mjx {
         strict
     };
 
+    enum class compression_mode : unsigned char {
+        unknown,
+        none,
+        fsst,
+        lz
+    };
+
     struct _Threads_option_traits { // traits for the '--threads' option
         static constexpr size_t _Unknown  = static_cast<size_t>(-1);
         static constexpr size_t _Auto     = static_cast<size_t>(-2);
@@ -31,10 +38,17 @@ namespace mjx {
     public:
         vector<path> input_files;
         path output_directory;
-        size_t threads              = _Threads_option_traits::_Unknown;
-        error_model model           = error_model::unknown;
-        bool discard_empty_messages = false;
-        bool generate_symbol_file   = false;
+        size_t threads               = _Threads_option_traits::_Unknown;
+        error_model model            = error_model::unknown;
+        compression_mode compression = compression_mode::unknown;
+        bool discard_empty_messages  = false;
+        bool generate_symbol_file    = false;
+        bool generate_hash_header    = false;
+        bool sort_lookup_table       = false;
+        bool perfect_hash_index      = false;
+        bool merge_tails             = false;
+        bool aligned_layout          = false;
+        bool ordinal_ids             = false;
     
         // returns the global instance of the program options
         static program_options& current() noexcept;
@@ -60,6 +74,9 @@ namespace mjx {
 
         // parses '--error-model' option
         static void _Parse_error_model(const unicode_string_view _Value) noexcept;
+
+        // parses '--compression' option
+        static void _Parse_compression(const unicode_string_view _Value) noexcept;
     };
 
     void parse_program_args(int _Count, wchar_t** _Args);
@@ -0,0 +1,224 @@
+// simd.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <bit>
+#include <ulpcl/simd.hpp>
+#if defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2)
+#define _ULPCL_SSE2_AVAILABLE 1
+#include <immintrin.h>
+#include <intrin.h>
+#else // ^^^ SSE2 available ^^^ / vvv SSE2 not available vvv
+#define _ULPCL_SSE2_AVAILABLE 0
+#endif // defined(_M_X64) || (defined(_M_IX86) && _M_IX86_FP >= 2)
+
+namespace mjx {
+    _Simd_level _Detect_simd_level() noexcept {
+#if _ULPCL_SSE2_AVAILABLE
+        int _Regs[4] = {0};
+        ::__cpuid(_Regs, 0);
+        if (_Regs[0] < 7) { // extended features not reported, AVX2 not available
+            return _Simd_level::_Sse2;
+        }
+
+        ::__cpuid(_Regs, 1);
+        const bool _Osxsave = (_Regs[2] & (1 << 27)) != 0;
+        const bool _Avx     = (_Regs[2] & (1 << 28)) != 0;
+        if (!_Osxsave || !_Avx || (::_xgetbv(0) & 0x6) != 0x6) { // OS does not preserve YMM registers
+            return _Simd_level::_Sse2;
+        }
+
+        ::__cpuidex(_Regs, 7, 0);
+        return (_Regs[1] & (1 << 5)) != 0 ? _Simd_level::_Avx2 : _Simd_level::_Sse2;
+#else // ^^^ _ULPCL_SSE2_AVAILABLE ^^^ / vvv !_ULPCL_SSE2_AVAILABLE vvv
+        return _Simd_level::_Scalar;
+#endif // _ULPCL_SSE2_AVAILABLE
+    }
+
+    // Note: Each byte class below provides a scalar predicate and its vectorized equivalents.
+    //       The vectorized predicates set every byte of the result to 0xFF if the corresponding
+    //       input byte belongs to the class. The '\t', '\n', '\v', '\f' and '\r' characters form
+    //       a contiguous range (0x09-0x0D), which is checked with a single signed comparison after
+    //       shifting the range to the bottom of the signed 8-bit domain (0x09 + 0x77 = 0x80).
+    struct _Structural_byte_class {
+        static bool _Match(const byte_t _Ch) noexcept {
+            switch (_Ch) {
+            case '\t':
+            case '\n':
+            case '\v':
+            case '\f':
+            case '\r':
+            case ' ':
+            case '"':
+            case '/':
+            case ':':
+            case '{':
+            case '}':
+                return true;
+            default:
+                return false;
+            }
+        }
+
+#if _ULPCL_SSE2_AVAILABLE
+        static __m128i _Match(const __m128i _Bytes) noexcept {
+            const __m128i _Shifted = _mm_add_epi8(_Bytes, _mm_set1_epi8(0x77));
+            __m128i _Mask          = _mm_cmpgt_epi8(_mm_set1_epi8(-123), _Shifted); // '\t' to '\r'
+            _Mask                  = _mm_or_si128(_Mask, _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8(' ')));
+            _Mask                  = _mm_or_si128(_Mask, _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8('"')));
+            _Mask                  = _mm_or_si128(_Mask, _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8('/')));
+            _Mask                  = _mm_or_si128(_Mask, _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8(':')));
+            _Mask                  = _mm_or_si128(_Mask, _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8('{')));
+            return _mm_or_si128(_Mask, _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8('}')));
+        }
+
+        static __m256i _Match(const __m256i _Bytes) noexcept {
+            const __m256i _Shifted = _mm256_add_epi8(_Bytes, _mm256_set1_epi8(0x77));
+            __m256i _Mask          = _mm256_cmpgt_epi8(_mm256_set1_epi8(-123), _Shifted); // '\t' to '\r'
+            _Mask                  = _mm256_or_si256(_Mask, _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8(' ')));
+            _Mask                  = _mm256_or_si256(_Mask, _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8('"')));
+            _Mask                  = _mm256_or_si256(_Mask, _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8('/')));
+            _Mask                  = _mm256_or_si256(_Mask, _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8(':')));
+            _Mask                  = _mm256_or_si256(_Mask, _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8('{')));
+            return _mm256_or_si256(_Mask, _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8('}')));
+        }
+#endif // _ULPCL_SSE2_AVAILABLE
+    };
+
+    struct _Literal_byte_class {
+        static bool _Match(const byte_t _Ch) noexcept {
+            return (_Ch >= '\t' && _Ch <= '\r') || _Ch == '"';
+        }
+
+#if _ULPCL_SSE2_AVAILABLE
+        static __m128i _Match(const __m128i _Bytes) noexcept {
+            const __m128i _Shifted = _mm_add_epi8(_Bytes, _mm_set1_epi8(0x77));
+            const __m128i _Mask    = _mm_cmpgt_epi8(_mm_set1_epi8(-123), _Shifted); // '\t' to '\r'
+            return _mm_or_si128(_Mask, _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8('"')));
+        }
+
+        static __m256i _Match(const __m256i _Bytes) noexcept {
+            const __m256i _Shifted = _mm256_add_epi8(_Bytes, _mm256_set1_epi8(0x77));
+            const __m256i _Mask    = _mm256_cmpgt_epi8(_mm256_set1_epi8(-123), _Shifted); // '\t' to '\r'
+            return _mm256_or_si256(_Mask, _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8('"')));
+        }
+#endif // _ULPCL_SSE2_AVAILABLE
+    };
+
+    struct _Eol_byte_class {
+        static bool _Match(const byte_t _Ch) noexcept {
+            return _Ch == '\n';
+        }
+
+#if _ULPCL_SSE2_AVAILABLE
+        static __m128i _Match(const __m128i _Bytes) noexcept {
+            return _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8('\n'));
+        }
+
+        static __m256i _Match(const __m256i _Bytes) noexcept {
+            return _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8('\n'));
+        }
+#endif // _ULPCL_SSE2_AVAILABLE
+    };
+
+    class _Other_byte_class { // matches any byte other than the specified one
+    public:
+        explicit _Other_byte_class(const byte_t _Ch) noexcept : _Mych(_Ch) {}
+
+        bool _Match(const byte_t _Ch) const noexcept {
+            return _Ch != _Mych;
+        }
+
+#if _ULPCL_SSE2_AVAILABLE
+        __m128i _Match(const __m128i _Bytes) const noexcept {
+            const __m128i _Equal = _mm_cmpeq_epi8(_Bytes, _mm_set1_epi8(static_cast<char>(_Mych)));
+            return _mm_xor_si128(_Equal, _mm_set1_epi8(-1)); // invert the result
+        }
+
+        __m256i _Match(const __m256i _Bytes) const noexcept {
+            const __m256i _Equal = _mm256_cmpeq_epi8(_Bytes, _mm256_set1_epi8(static_cast<char>(_Mych)));
+            return _mm256_xor_si256(_Equal, _mm256_set1_epi8(-1)); // invert the result
+        }
+#endif // _ULPCL_SSE2_AVAILABLE
+
+    private:
+        byte_t _Mych;
+    };
+
+#if _ULPCL_SSE2_AVAILABLE
+    template <class _Class>
+    inline const byte_t* _Find_first_avx2(
+        const byte_t* _First, const byte_t* const _Last, const _Class& _Pred) noexcept {
+        // examine 32 bytes at once, returns the position at which fewer than 32 bytes remain if not found
+        for (; _Last - _First >= 32; _First += 32) {
+            const __m256i _Bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_First));
+            const unsigned int _Mask =
+                static_cast<unsigned int>(_mm256_movemask_epi8(_Pred._Match(_Bytes)));
+            if (_Mask != 0) { // at least one byte matched, return the first one
+                return _First + ::std::countr_zero(_Mask);
+            }
+        }
+
+        return _First;
+    }
+
+    template <class _Class>
+    inline const byte_t* _Find_first_sse2(
+        const byte_t* _First, const byte_t* const _Last, const _Class& _Pred) noexcept {
+        // examine 16 bytes at once, returns the position at which fewer than 16 bytes remain if not found
+        for (; _Last - _First >= 16; _First += 16) {
+            const __m128i _Bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_First));
+            const unsigned int _Mask =
+                static_cast<unsigned int>(_mm_movemask_epi8(_Pred._Match(_Bytes)));
+            if (_Mask != 0) { // at least one byte matched, return the first one
+                return _First + ::std::countr_zero(_Mask);
+            }
+        }
+
+        return _First;
+    }
+#endif // _ULPCL_SSE2_AVAILABLE
+
+    template <class _Class>
+    inline const byte_t* _Find_first(const byte_t* _First, const byte_t* const _Last, const _Class& _Pred) noexcept {
+#if _ULPCL_SSE2_AVAILABLE
+        static const _Simd_level _Level = _Detect_simd_level();
+        if (_Level == _Simd_level::_Avx2) {
+            _First = _Find_first_avx2(_First, _Last, _Pred);
+            if (_Last - _First >= 32) { // found before the tail
+                return _First;
+            }
+        }
+
+        _First = _Find_first_sse2(_First, _Last, _Pred);
+        if (_Last - _First >= 16) { // found before the tail
+            return _First;
+        }
+#endif // _ULPCL_SSE2_AVAILABLE
+
+        for (; _First != _Last; ++_First) { // examine the remaining bytes one by one
+            if (_Pred._Match(*_First)) {
+                break;
+            }
+        }
+
+        return _First;
+    }
+
+    const byte_t* _Find_structural_byte(const byte_t* _First, const byte_t* const _Last) noexcept {
+        return _Find_first(_First, _Last, _Structural_byte_class{});
+    }
+
+    const byte_t* _Find_literal_byte(const byte_t* _First, const byte_t* const _Last) noexcept {
+        return _Find_first(_First, _Last, _Literal_byte_class{});
+    }
+
+    const byte_t* _Find_eol(const byte_t* _First, const byte_t* const _Last) noexcept {
+        return _Find_first(_First, _Last, _Eol_byte_class{});
+    }
+
+    const byte_t* _Find_other_byte(const byte_t* _First, const byte_t* const _Last, const byte_t _Ch) noexcept {
+        return _Find_first(_First, _Last, _Other_byte_class{_Ch});
+    }
+} // namespace mjx
\ No newline at end of file
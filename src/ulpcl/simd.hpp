@@ -0,0 +1,34 @@
+// simd.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_SIMD_HPP_
+#define _ULPCL_SIMD_HPP_
+#include <mjstr/char_traits.hpp>
+
+namespace mjx {
+    enum class _Simd_level : unsigned char {
+        _Scalar,
+        _Sse2,
+        _Avx2
+    };
+
+    // returns the highest SIMD instruction set supported by the current processor
+    _Simd_level _Detect_simd_level() noexcept;
+
+    // finds the first byte that may change the state of the lexer outside comments and string literals
+    const byte_t* _Find_structural_byte(const byte_t* _First, const byte_t* const _Last) noexcept;
+
+    // finds the first byte that may change the state of the lexer inside a string literal
+    const byte_t* _Find_literal_byte(const byte_t* _First, const byte_t* const _Last) noexcept;
+
+    // finds the first end of line
+    const byte_t* _Find_eol(const byte_t* _First, const byte_t* const _Last) noexcept;
+
+    // finds the first byte that is different from _Ch
+    const byte_t* _Find_other_byte(const byte_t* _First, const byte_t* const _Last, const byte_t _Ch) noexcept;
+} // namespace mjx
+
+#endif // _ULPCL_SIMD_HPP_
\ No newline at end of file
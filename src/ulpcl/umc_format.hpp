@@ -0,0 +1,75 @@
+// umc_format.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_UMC_FORMAT_HPP_
+#define _ULPCL_UMC_FORMAT_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjstr/char_traits.hpp>
+
+namespace mjx {
+    // Note: This header describes the UMC file format, it is shared by the compiler and the reader,
+    //       so it must not depend on any other part of the compiler.
+
+#pragma pack(push)
+#pragma pack(4) // align structure members on 4-byte boundaries to avoid alignment issues
+                // while copying raw data
+    struct _Lookup_table_entry {
+        uint64_t _Hash   = 0;
+        uint64_t _Offset = 0;
+        uint32_t _Length = 0;
+    };
+
+    struct _Compressed_lookup_table_entry {
+        uint64_t _Hash           = 0;
+        uint64_t _Offset         = 0;
+        uint32_t _Length         = 0; // length of the compressed value
+        uint32_t _Decoded_length = 0; // length of the value after decompression
+    };
+
+    struct _Value_location { // lookup table entry without the hash, used if the hashes are stored separately
+        uint64_t _Offset = 0;
+        uint32_t _Length = 0;
+    };
+
+    struct _Compressed_value_location {
+        uint64_t _Offset         = 0;
+        uint32_t _Length         = 0; // length of the compressed value
+        uint32_t _Decoded_length = 0; // length of the value after decompression
+    };
+
+    struct _Block_index_entry {
+        uint64_t _Offset            = 0; // offset of the block in the decompressed blob
+        uint64_t _Compressed_offset = 0; // offset of the block in the blob
+        uint32_t _Length            = 0; // length of the decompressed block
+        uint32_t _Compressed_length = 0; // length of the block in the blob
+    };
+#pragma pack(pop)
+
+    struct _Umc_flags { // flags stored in the last byte of the UMC file signature
+        static constexpr byte_t _None                = 0x00;
+        static constexpr byte_t _Sorted_lookup_table = 0x01; // lookup table entries are sorted by hashes
+        static constexpr byte_t _Perfect_hash_index  = 0x02; // perfect hash index precedes the lookup table
+        static constexpr byte_t _Compressed_values   = 0x04; // values are compressed with a symbol table
+        static constexpr byte_t _Compressed_blocks   = 0x08; // blob is split into compressed blocks
+        static constexpr byte_t _Aligned_sections    = 0x10; // sections are aligned, hashes are stored separately
+        static constexpr byte_t _Ordinal_table       = 0x20; // value locations are indexed by ordinals, no hashes
+        static constexpr byte_t _All                 = 0x3F;
+    };
+
+    struct _Umc_layout { // layout constants shared by the writer and the reader
+        static constexpr size_t _Signature_length  = 4; // 'UMC' followed by the flags
+        static constexpr size_t _Section_alignment = 64; // cache line size
+        static constexpr uint64_t _Absent_offset   = ~0ULL; // value offset of the ordinals with no message
+
+        // returns the offset rounded up to the section alignment
+        static constexpr uint64_t _Align_offset(const uint64_t _Offset) noexcept {
+            return (_Offset + (_Section_alignment - 1)) & ~static_cast<uint64_t>(_Section_alignment - 1);
+        }
+    };
+} // namespace mjx
+
+#endif // _ULPCL_UMC_FORMAT_HPP_
\ No newline at end of file
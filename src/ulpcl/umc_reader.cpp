@@ -0,0 +1,603 @@
+// umc_reader.cpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+#include <mjfs/file.hpp>
+#include <type_traits>
+#include <ulpcl/lz_codec.hpp>
+#include <ulpcl/perfect_hash.hpp>
+#include <ulpcl/umc_format.hpp>
+#include <ulpcl/umc_reader.hpp>
+#include <xxhash/xxhash.h>
+
+namespace mjx {
+    template <class _Ty>
+    _Ty _Load_unaligned(const byte_t* const _Ptr) noexcept {
+        // Note: The fields of the UMC file are not guaranteed to be aligned, so they are copied
+        //       rather than dereferenced. Compilers turn such copies into plain loads.
+        _Ty _Value;
+        ::memcpy(&_Value, _Ptr, sizeof(_Ty));
+        return _Value;
+    }
+
+    inline void _Prefetch(const void* const _Ptr) noexcept {
+        ::_mm_prefetch(static_cast<const char*>(_Ptr), _MM_HINT_T0);
+    }
+
+    umc_reader::umc_reader() noexcept
+        : _Myfile(), _Mylang(), _Mylcid(0), _Mycount(0), _Myflags(_Umc_flags::_None), _Myseed(0), _Mybuckets(0),
+        _Myordinals(0), _Mypilots(nullptr), _Myhashes(nullptr), _Mylocations(nullptr), _Myblocks(nullptr),
+        _Myblock_count(0), _Myblob(), _Mytable(), _Myorder() {}
+
+    umc_reader::umc_reader(umc_reader&& _Other) noexcept
+        : _Myfile(::std::move(_Other._Myfile)), _Mylang(_Other._Mylang), _Mylcid(_Other._Mylcid),
+        _Mycount(_Other._Mycount), _Myflags(_Other._Myflags), _Myseed(_Other._Myseed),
+        _Mybuckets(_Other._Mybuckets), _Myordinals(_Other._Myordinals), _Mypilots(_Other._Mypilots),
+        _Myhashes(_Other._Myhashes), _Mylocations(_Other._Mylocations), _Myblocks(_Other._Myblocks),
+        _Myblock_count(_Other._Myblock_count), _Myblob(_Other._Myblob), _Mytable(::std::move(_Other._Mytable)),
+        _Myorder(::std::move(_Other._Myorder)) {
+        _Other.close();
+    }
+
+    umc_reader::~umc_reader() noexcept {}
+
+    umc_reader::umc_reader(const path& _Target) : umc_reader() {
+        file _File(_Target, file_access::read, file_share::read);
+        if (!_File.is_open()) { // failed to open the UMC file, break
+            return;
+        }
+
+        _Myfile = mapped_file(_File);
+        if (!_Myfile.is_open() || !_Parse()) { // unreadable or malformed UMC file, release it
+            close();
+        }
+    }
+
+    umc_reader& umc_reader::operator=(umc_reader&& _Other) noexcept {
+        if (this != ::std::addressof(_Other)) {
+            _Myfile        = ::std::move(_Other._Myfile);
+            _Mylang        = _Other._Mylang;
+            _Mylcid        = _Other._Mylcid;
+            _Mycount       = _Other._Mycount;
+            _Myflags       = _Other._Myflags;
+            _Myseed        = _Other._Myseed;
+            _Mybuckets     = _Other._Mybuckets;
+            _Myordinals    = _Other._Myordinals;
+            _Mypilots      = _Other._Mypilots;
+            _Myhashes      = _Other._Myhashes;
+            _Mylocations   = _Other._Mylocations;
+            _Myblocks      = _Other._Myblocks;
+            _Myblock_count = _Other._Myblock_count;
+            _Myblob        = _Other._Myblob;
+            _Mytable       = ::std::move(_Other._Mytable);
+            _Myorder       = ::std::move(_Other._Myorder);
+            _Other.close();
+        }
+
+        return *this;
+    }
+
+    bool umc_reader::_Parse() {
+        const byte_string_view _Data = _Myfile.view();
+        size_t _Off                  = 0;
+        const auto _Take             = [&_Data, &_Off](const uint64_t _Size) noexcept -> const byte_t* {
+            if (_Size > _Data.size() - _Off) { // the section exceeds the file, break
+                return nullptr;
+            }
+
+            const byte_t* const _Ptr = _Data.data() + _Off;
+            _Off                    += static_cast<size_t>(_Size);
+            return _Ptr;
+        };
+        const auto _Align_section = [this, &_Data, &_Off]() noexcept {
+            if (!(_Myflags & _Umc_flags::_Aligned_sections)) { // sections are not aligned, do nothing
+                return true;
+            }
+
+            const uint64_t _Aligned = _Umc_layout::_Align_offset(_Off);
+            if (_Aligned > _Data.size()) { // the padding exceeds the file, break
+                return false;
+            }
+
+            _Off = static_cast<size_t>(_Aligned);
+            return true;
+        };
+
+        const byte_t* const _Signature = _Take(_Umc_layout::_Signature_length);
+        if (!_Signature || _Signature[0] != 'U' || _Signature[1] != 'M' || _Signature[2] != 'C') {
+            return false;
+        }
+
+        _Myflags = _Signature[3];
+        if (_Myflags & ~_Umc_flags::_All) { // unknown flags, break
+            return false;
+        }
+
+        const byte_t* const _Lang_length = _Take(1);
+        const byte_t* const _Lang        = _Lang_length ? _Take(*_Lang_length) : nullptr;
+        const byte_t* const _Lcid        = _Lang ? _Take(sizeof(uint32_t)) : nullptr;
+        const byte_t* const _Count       = _Lcid ? _Take(sizeof(uint32_t)) : nullptr;
+        if (!_Count) { // incomplete header, break
+            return false;
+        }
+
+        _Mylang  = utf8_string_view{reinterpret_cast<const char*>(_Lang), *_Lang_length};
+        _Mylcid  = _Load_unaligned<uint32_t>(_Lcid);
+        _Mycount = _Load_unaligned<uint32_t>(_Count);
+        if (_Myflags & _Umc_flags::_Perfect_hash_index) { // seed, number of pilots and pilots
+            const byte_t* const _Index = _Align_section() ? _Take(sizeof(uint64_t) + sizeof(uint32_t)) : nullptr;
+            if (!_Index) { // incomplete perfect hash index, break
+                return false;
+            }
+
+            _Myseed    = _Load_unaligned<uint64_t>(_Index);
+            _Mybuckets = _Load_unaligned<uint32_t>(_Index + sizeof(uint64_t));
+            _Mypilots  = _Take(static_cast<uint64_t>(_Mybuckets) * sizeof(uint32_t));
+            if (!_Mypilots || _Mybuckets != _Perfect_hash_traits::_Bucket_count(_Mycount)) {
+                return false;
+            }
+        }
+
+        if (_Myflags & _Umc_flags::_Compressed_values) { // number of symbols, their lengths and their bytes
+            const byte_t* const _Symbol_count = _Align_section() ? _Take(1) : nullptr;
+            const byte_t* const _Lengths      = _Symbol_count ? _Take(*_Symbol_count) : nullptr;
+            if (!_Lengths) { // incomplete symbol table, break
+                return false;
+            }
+
+            vector<byte_string_view> _Symbols(*_Symbol_count);
+            for (size_t _Code = 0; _Code < _Symbols.size(); ++_Code) {
+                const byte_t* const _Bytes = _Take(_Lengths[_Code]);
+                if (!_Bytes) { // incomplete symbol, break
+                    return false;
+                }
+
+                _Symbols[_Code] = byte_string_view{_Bytes, _Lengths[_Code]};
+            }
+
+            if (!_Mytable.assign(_Symbols)) { // invalid symbol table, break
+                return false;
+            }
+        }
+
+        if (_Myflags & _Umc_flags::_Compressed_blocks) { // number of blocks and block index entries
+            const byte_t* const _Block_count = _Align_section() ? _Take(sizeof(uint32_t)) : nullptr;
+            if (!_Block_count) { // incomplete block index, break
+                return false;
+            }
+
+            _Myblock_count = _Load_unaligned<uint32_t>(_Block_count);
+            _Myblocks      = _Take(static_cast<uint64_t>(_Myblock_count) * sizeof(_Block_index_entry));
+            if (!_Myblocks) { // incomplete block index, break
+                return false;
+            }
+        }
+
+        if (_Myflags & _Umc_flags::_Ordinal_table) { // number of ordinals and value locations
+            const byte_t* const _Ordinals = _Align_section() ? _Take(sizeof(uint32_t)) : nullptr;
+            if (!_Ordinals) { // incomplete ordinal table, break
+                return false;
+            }
+
+            _Myordinals  = _Load_unaligned<uint32_t>(_Ordinals);
+            _Mylocations = _Take(static_cast<uint64_t>(_Myordinals) * _Location_size());
+            if (!_Mylocations) { // incomplete ordinal table, break
+                return false;
+            }
+        } else if (_Myflags & _Umc_flags::_Aligned_sections) { // hashes and value locations are stored separately
+            _Myhashes    = _Align_section() ? _Take(static_cast<uint64_t>(_Mycount) * sizeof(uint64_t)) : nullptr;
+            _Mylocations = _Myhashes && _Align_section()
+                ? _Take(static_cast<uint64_t>(_Mycount) * _Location_size()) : nullptr;
+            if (!_Mylocations) { // incomplete lookup table, break
+                return false;
+            }
+        } else {
+            _Myhashes = _Take(static_cast<uint64_t>(_Mycount) * _Entry_size());
+            if (!_Myhashes) { // incomplete lookup table, break
+                return false;
+            }
+        }
+
+        if (!_Align_section()) { // misplaced blob, break
+            return false;
+        }
+
+        _Myblob = byte_string_view{_Data.data() + _Off, _Data.size() - _Off};
+        if (_Myhashes && !(_Myflags & (_Umc_flags::_Sorted_lookup_table | _Umc_flags::_Perfect_hash_index))) {
+            // the entries are stored in the declaration order, order them by hashes for binary search
+            _Myorder.resize(_Mycount);
+            for (uint32_t _Idx = 0; _Idx < _Mycount; ++_Idx) {
+                _Myorder[_Idx] = _Idx;
+            }
+
+            ::std::sort(_Myorder.begin(), _Myorder.end(),
+                [this](const uint32_t _Left, const uint32_t _Right) noexcept {
+                    return _Hash_at(_Left) < _Hash_at(_Right);
+                }
+            );
+        }
+
+        return true;
+    }
+
+    size_t umc_reader::_Entry_size() const noexcept {
+        // the compressed values have an additional field that stores their decoded lengths
+        return _Myflags & _Umc_flags::_Compressed_values
+            ? sizeof(_Compressed_lookup_table_entry) : sizeof(_Lookup_table_entry);
+    }
+
+    size_t umc_reader::_Location_size() const noexcept {
+        return _Myflags & _Umc_flags::_Compressed_values
+            ? sizeof(_Compressed_value_location) : sizeof(_Value_location);
+    }
+
+    const byte_t* umc_reader::_Hash_address(const uint32_t _Idx) const noexcept {
+        const size_t _Stride = _Mylocations ? sizeof(uint64_t) : _Entry_size();
+        return _Myhashes + _Idx * _Stride;
+    }
+
+    uint64_t umc_reader::_Hash_at(const uint32_t _Idx) const noexcept {
+        return _Load_unaligned<uint64_t>(_Hash_address(_Idx));
+    }
+
+    const byte_t* umc_reader::_Location_address(const uint32_t _Idx) const noexcept {
+        // the location follows the hash, unless the hashes are stored separately
+        return _Mylocations ? _Mylocations + _Idx * _Location_size()
+                            : _Myhashes + _Idx * _Entry_size() + sizeof(uint64_t);
+    }
+
+    uint32_t umc_reader::_Find(const uint64_t _Hash) const noexcept {
+        if (_Mycount == 0 || !_Myhashes) { // no messages or no hashes, break
+            return _Not_found;
+        }
+
+        if (_Mypilots) { // compute the position of the entry
+            const uint64_t _Mixed  = _Perfect_hash_traits::_Mix(_Hash ^ _Myseed);
+            const uint32_t _Bucket = _Perfect_hash_traits::_Bucket(_Mixed, _Mybuckets);
+            const uint32_t _Idx    = _Perfect_hash_traits::_Position(
+                _Mixed, _Load_unaligned<uint32_t>(_Mypilots + _Bucket * sizeof(uint32_t)), _Mycount);
+            return _Hash_at(_Idx) == _Hash ? _Idx : _Not_found; // any hash maps to some position
+        }
+
+        // search for the first entry whose hash is not less than _Hash
+        const bool _Sorted = (_Myflags & _Umc_flags::_Sorted_lookup_table) != 0;
+        uint32_t _First    = 0;
+        uint32_t _Count    = _Mycount;
+        while (_Count > 0) {
+            const uint32_t _Half = _Count / 2;
+            const uint32_t _Mid  = _First + _Half;
+            if (_Hash_at(_Sorted ? _Mid : _Myorder[_Mid]) < _Hash) {
+                _First  = _Mid + 1;
+                _Count -= _Half + 1;
+            } else {
+                _Count = _Half;
+            }
+        }
+
+        if (_First == _Mycount) { // all hashes are less than _Hash, break
+            return _Not_found;
+        }
+
+        const uint32_t _Idx = _Sorted ? _First : _Myorder[_First];
+        return _Hash_at(_Idx) == _Hash ? _Idx : _Not_found;
+    }
+
+    utf8_string_view umc_reader::_Value_at(const uint32_t _Idx) const noexcept {
+        if (is_compressed()) { // the value must be decoded first
+            return utf8_string_view{};
+        }
+
+        const byte_t* const _Location = _Location_address(_Idx);
+        const uint64_t _Offset        = _Load_unaligned<uint64_t>(_Location);
+        const uint32_t _Length        = _Load_unaligned<uint32_t>(_Location + sizeof(uint64_t));
+        if (_Offset > _Myblob.size() || _Length > _Myblob.size() - _Offset) { // the value exceeds the blob, break
+            return utf8_string_view{};
+        }
+
+        return utf8_string_view{reinterpret_cast<const char*>(_Myblob.data() + _Offset), _Length};
+    }
+
+    bool umc_reader::_Decode_at(const uint32_t _Idx, utf8_string& _Value) const {
+        const byte_t* const _Location = _Location_address(_Idx);
+        const uint64_t _Offset        = _Load_unaligned<uint64_t>(_Location);
+        const uint32_t _Length        = _Load_unaligned<uint32_t>(_Location + sizeof(uint64_t));
+        if (_Myflags & _Umc_flags::_Compressed_blocks) { // the location refers to the decompressed blob
+            return _Decode_from_block(_Offset, _Length, _Value);
+        }
+
+        if (_Offset > _Myblob.size() || _Length > _Myblob.size() - _Offset) { // the value exceeds the blob, break
+            _Value.clear();
+            return false;
+        }
+
+        const byte_string_view _Data{_Myblob.data() + _Offset, _Length};
+        if (!(_Myflags & _Umc_flags::_Compressed_values)) { // copy the value as it is
+            _Value.assign(reinterpret_cast<const char*>(_Data.data()), _Data.size());
+            return true;
+        }
+
+        // each code is decoded into at most max_symbol_length bytes, so a longer value must be malformed
+        const uint32_t _Decoded_length = _Load_unaligned<uint32_t>(_Location + sizeof(uint64_t) + sizeof(uint32_t));
+        if (_Decoded_length > static_cast<uint64_t>(_Length) * fsst_table::max_symbol_length) {
+            _Value.clear();
+            return false;
+        }
+
+        _Value.resize(_Decoded_length);
+        if (!_Mytable.decompress(_Data, reinterpret_cast<byte_t*>(_Value.data()), _Decoded_length)) {
+            _Value.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    _Block_index_entry umc_reader::_Block_at(const uint32_t _Idx) const noexcept {
+        return _Load_unaligned<_Block_index_entry>(_Myblocks + _Idx * sizeof(_Block_index_entry));
+    }
+
+    bool umc_reader::_Decode_from_block(const uint64_t _Offset, const uint32_t _Length, utf8_string& _Value) const {
+        // Note: A value never spans multiple blocks, so only the block that contains the value is decompressed.
+        //       The blocks are sorted by their offsets, so the block is found using binary search.
+        const _Block_index_entry _Last = _Myblock_count > 0 ? _Block_at(_Myblock_count - 1) : _Block_index_entry{};
+        const uint64_t _Blob_size      = _Last._Offset + _Last._Length; // the size of the decompressed blob
+        if (_Offset > _Blob_size || _Length > _Blob_size - _Offset) { // the value exceeds the blob, break
+            _Value.clear();
+            return false;
+        }
+
+        if (_Length == 0) { // empty value, nothing to decompress
+            _Value.clear();
+            return true;
+        }
+
+        // search for the first block whose offset is greater than _Offset, the value is in the preceding one
+        uint32_t _First = 0;
+        uint32_t _Count = _Myblock_count;
+        while (_Count > 0) {
+            const uint32_t _Half = _Count / 2;
+            const uint32_t _Mid  = _First + _Half;
+            if (_Block_at(_Mid)._Offset <= _Offset) {
+                _First  = _Mid + 1;
+                _Count -= _Half + 1;
+            } else {
+                _Count = _Half;
+            }
+        }
+
+        const _Block_index_entry _Block = _First > 0 ? _Block_at(_First - 1) : _Block_index_entry{};
+        if (_First == 0 || _Length > _Block._Length || _Offset - _Block._Offset > _Block._Length - _Length
+            || _Block._Compressed_offset > _Myblob.size()
+            || _Block._Compressed_length > _Myblob.size() - _Block._Compressed_offset) { // malformed block, break
+            _Value.clear();
+            return false;
+        }
+
+        byte_string _Decoded;
+        const byte_string_view _Data{_Myblob.data() + _Block._Compressed_offset, _Block._Compressed_length};
+        if (!::mjx::lz_decompress(_Data, _Block._Length, _Decoded)) { // malformed block, break
+            _Value.clear();
+            return false;
+        }
+
+        _Value.assign(reinterpret_cast<const char*>(_Decoded.data() + (_Offset - _Block._Offset)), _Length);
+        return true;
+    }
+
+    void umc_reader::_Find_batch(
+        const uint64_t* const _Hashes, const size_t _Count, uint32_t* const _Indexes) const noexcept {
+        // Note: Each search is a chain of dependent memory accesses, so the searches are performed
+        //       step by step, all at once. In each step, the memory that the next step of each search
+        //       will touch is prefetched first, so that the cache misses of the whole batch overlap.
+        if (_Mypilots) { // the bucket, the pilot and the entry
+            uint64_t _Mixed[_Batch_size];
+            uint32_t _Buckets[_Batch_size];
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                _Mixed[_Idx]   = _Perfect_hash_traits::_Mix(_Hashes[_Idx] ^ _Myseed);
+                _Buckets[_Idx] = _Perfect_hash_traits::_Bucket(_Mixed[_Idx], _Mybuckets);
+                _Prefetch(_Mypilots + _Buckets[_Idx] * sizeof(uint32_t));
+            }
+
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                _Indexes[_Idx] = _Perfect_hash_traits::_Position(_Mixed[_Idx],
+                    _Load_unaligned<uint32_t>(_Mypilots + _Buckets[_Idx] * sizeof(uint32_t)), _Mycount);
+                _Prefetch(_Hash_address(_Indexes[_Idx]));
+            }
+
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                if (_Hash_at(_Indexes[_Idx]) != _Hashes[_Idx]) { // any hash maps to some position
+                    _Indexes[_Idx] = _Not_found;
+                }
+            }
+
+            return;
+        }
+
+        // interleave the binary searches, each one stops when its range becomes empty
+        const bool _Sorted = (_Myflags & _Umc_flags::_Sorted_lookup_table) != 0;
+        uint32_t _First[_Batch_size];
+        uint32_t _Remaining[_Batch_size];
+        for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+            _First[_Idx]     = 0;
+            _Remaining[_Idx] = _Mycount;
+        }
+
+        for (bool _Active = true; _Active;) {
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                if (_Remaining[_Idx] > 0) { // prefetch the middle entry
+                    const uint32_t _Mid = _First[_Idx] + _Remaining[_Idx] / 2;
+                    _Prefetch(_Hash_address(_Sorted ? _Mid : _Myorder[_Mid]));
+                }
+            }
+
+            _Active = false;
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                if (_Remaining[_Idx] == 0) { // search finished, skip it
+                    continue;
+                }
+
+                const uint32_t _Half = _Remaining[_Idx] / 2;
+                const uint32_t _Mid  = _First[_Idx] + _Half;
+                if (_Hash_at(_Sorted ? _Mid : _Myorder[_Mid]) < _Hashes[_Idx]) {
+                    _First[_Idx]      = _Mid + 1;
+                    _Remaining[_Idx] -= _Half + 1;
+                } else {
+                    _Remaining[_Idx] = _Half;
+                }
+
+                _Active = _Active || _Remaining[_Idx] > 0;
+            }
+        }
+
+        for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+            if (_First[_Idx] == _Mycount) { // all hashes are less than the searched one
+                _Indexes[_Idx] = _Not_found;
+                continue;
+            }
+
+            const uint32_t _Entry = _Sorted ? _First[_Idx] : _Myorder[_First[_Idx]];
+            _Indexes[_Idx]        = _Hash_at(_Entry) == _Hashes[_Idx] ? _Entry : _Not_found;
+        }
+    }
+
+    void umc_reader::_Lookup_batch(
+        const uint64_t* const _Hashes, const size_t _Count, utf8_string_view* const _Values) const noexcept {
+        uint32_t _Indexes[_Batch_size];
+        if (_Mycount == 0 || !_Myhashes) { // no messages or no hashes, nothing can be found
+            for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+                _Indexes[_Idx] = _Not_found;
+            }
+        } else {
+            _Find_batch(_Hashes, _Count, _Indexes);
+        }
+
+        for (size_t _Idx = 0; _Idx < _Count; ++_Idx) { // prefetch the value locations
+            if (_Indexes[_Idx] != _Not_found) {
+                _Prefetch(_Location_address(_Indexes[_Idx]));
+            }
+        }
+
+        for (size_t _Idx = 0; _Idx < _Count; ++_Idx) { // prefetch the beginnings of the values
+            if (_Indexes[_Idx] != _Not_found) {
+                const uint64_t _Offset = _Load_unaligned<uint64_t>(_Location_address(_Indexes[_Idx]));
+                if (_Offset < _Myblob.size()) {
+                    _Prefetch(_Myblob.data() + _Offset);
+                }
+            }
+        }
+
+        for (size_t _Idx = 0; _Idx < _Count; ++_Idx) {
+            _Values[_Idx] = _Indexes[_Idx] != _Not_found ? _Value_at(_Indexes[_Idx]) : utf8_string_view{};
+        }
+    }
+
+    bool umc_reader::is_open() const noexcept {
+        return _Myfile.is_open();
+    }
+
+    utf8_string_view umc_reader::language() const noexcept {
+        return _Mylang;
+    }
+
+    uint32_t umc_reader::lcid() const noexcept {
+        return _Mylcid;
+    }
+
+    uint32_t umc_reader::size() const noexcept {
+        return _Mycount;
+    }
+
+    bool umc_reader::contains(const utf8_string_view _Id) const noexcept {
+        return _Find(::XXH3_64bits(_Id.data(), _Id.size())) != _Not_found;
+    }
+
+    bool umc_reader::is_compressed() const noexcept {
+        return (_Myflags & (_Umc_flags::_Compressed_values | _Umc_flags::_Compressed_blocks)) != 0;
+    }
+
+    utf8_string_view umc_reader::lookup(const utf8_string_view _Id) const noexcept {
+        // Note: The compiler hashes the qualified IDs with XXH3-64 and no seed, see _Id_prefix::_Compute_hash().
+        return lookup_hash(::XXH3_64bits(_Id.data(), _Id.size()));
+    }
+
+    utf8_string_view umc_reader::lookup_hash(const uint64_t _Hash) const noexcept {
+        const uint32_t _Idx = _Find(_Hash);
+        return _Idx != _Not_found ? _Value_at(_Idx) : utf8_string_view{};
+    }
+
+    void umc_reader::lookup(
+        const utf8_string_view* const _Ids, const size_t _Count, utf8_string_view* const _Values) const noexcept {
+        uint64_t _Hashes[_Batch_size];
+        for (size_t _Off = 0; _Off < _Count; _Off += _Batch_size) {
+            // the hashes don't depend on each other, so the processor can compute them in parallel
+            const size_t _Size = (::std::min)(_Count - _Off, _Batch_size);
+            for (size_t _Idx = 0; _Idx < _Size; ++_Idx) {
+                _Hashes[_Idx] = ::XXH3_64bits(_Ids[_Off + _Idx].data(), _Ids[_Off + _Idx].size());
+            }
+
+            _Lookup_batch(_Hashes, _Size, _Values + _Off);
+        }
+    }
+
+    void umc_reader::lookup_hash(
+        const uint64_t* const _Hashes, const size_t _Count, utf8_string_view* const _Values) const noexcept {
+        for (size_t _Off = 0; _Off < _Count; _Off += _Batch_size) {
+            _Lookup_batch(_Hashes + _Off, (::std::min)(_Count - _Off, _Batch_size), _Values + _Off);
+        }
+    }
+
+    uint32_t umc_reader::ordinal_count() const noexcept {
+        return _Myordinals;
+    }
+
+    utf8_string_view umc_reader::lookup_ordinal(const uint32_t _Ordinal) const noexcept {
+        // the ordinals with no message have an absent value offset, which _Value_at() rejects
+        return _Ordinal < _Myordinals ? _Value_at(_Ordinal) : utf8_string_view{};
+    }
+
+    bool umc_reader::lookup(const utf8_string_view _Id, utf8_string& _Value) const {
+        return lookup_hash(::XXH3_64bits(_Id.data(), _Id.size()), _Value);
+    }
+
+    bool umc_reader::lookup_hash(const uint64_t _Hash, utf8_string& _Value) const {
+        const uint32_t _Idx = _Find(_Hash);
+        if (_Idx == _Not_found) { // no such message, break
+            _Value.clear();
+            return false;
+        }
+
+        return _Decode_at(_Idx, _Value);
+    }
+
+    bool umc_reader::lookup_ordinal(const uint32_t _Ordinal, utf8_string& _Value) const {
+        if (_Ordinal >= _Myordinals) { // no such ordinal, break
+            _Value.clear();
+            return false;
+        }
+
+        return _Decode_at(_Ordinal, _Value);
+    }
+
+    void umc_reader::close() noexcept {
+        _Myfile.close();
+        _Mylang        = utf8_string_view{};
+        _Mylcid        = 0;
+        _Mycount       = 0;
+        _Myflags       = _Umc_flags::_None;
+        _Myseed        = 0;
+        _Mybuckets     = 0;
+        _Myordinals    = 0;
+        _Mypilots      = nullptr;
+        _Myhashes      = nullptr;
+        _Mylocations   = nullptr;
+        _Myblocks      = nullptr;
+        _Myblock_count = 0;
+        _Myblob        = byte_string_view{};
+        _Mytable       = fsst_table{};
+        _Myorder.clear();
+    }
+} // namespace mjx
\ No newline at end of file
@@ -0,0 +1,157 @@
+// umc_reader.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_UMC_READER_HPP_
+#define _ULPCL_UMC_READER_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <mjfs/path.hpp>
+#include <mjstr/string.hpp>
+#include <mjstr/string_view.hpp>
+#include <ulpcl/fsst.hpp>
+#include <ulpcl/mapped_file.hpp>
+#include <ulpcl/umc_format.hpp>
+#include <ulpcl/utils.hpp>
+
+namespace mjx {
+    class umc_reader { // read-only view of a compiled UMC file
+    public:
+        umc_reader() noexcept;
+        umc_reader(umc_reader&& _Other) noexcept;
+        ~umc_reader() noexcept;
+
+        explicit umc_reader(const path& _Target);
+
+        umc_reader& operator=(umc_reader&& _Other) noexcept;
+
+        umc_reader(const umc_reader&)            = delete;
+        umc_reader& operator=(const umc_reader&) = delete;
+
+        // checks if the UMC file is open and valid
+        bool is_open() const noexcept;
+
+        // returns the name of the language to which the messages are translated
+        utf8_string_view language() const noexcept;
+
+        // returns the LCID of the language
+        uint32_t lcid() const noexcept;
+
+        // returns the number of messages
+        uint32_t size() const noexcept;
+
+        // checks if the message with the specified qualified ID exists
+        bool contains(const utf8_string_view _Id) const noexcept;
+
+        // checks if the values are compressed, they can be obtained only by decoding them into strings
+        bool is_compressed() const noexcept;
+
+        // returns the value of the message with the specified qualified ID,
+        // empty if not found or if the values are compressed (see is_compressed())
+        utf8_string_view lookup(const utf8_string_view _Id) const noexcept;
+
+        // returns the value of the message with the specified ID hash,
+        // empty if not found or if the values are compressed (see is_compressed())
+        utf8_string_view lookup_hash(const uint64_t _Hash) const noexcept;
+
+        // resolves the values of the messages with the specified qualified IDs at once,
+        // missing values are empty, all values are empty if they are compressed (see is_compressed())
+        void lookup(
+            const utf8_string_view* const _Ids, const size_t _Count, utf8_string_view* const _Values) const noexcept;
+
+        // resolves the values of the messages with the specified ID hashes at once,
+        // missing values are empty, all values are empty if they are compressed (see is_compressed())
+        void lookup_hash(
+            const uint64_t* const _Hashes, const size_t _Count, utf8_string_view* const _Values) const noexcept;
+
+        // returns the number of ordinals, zero if the values are not indexed by ordinals
+        uint32_t ordinal_count() const noexcept;
+
+        // returns the value of the message with the specified ordinal,
+        // empty if not found or if the values are compressed (see is_compressed())
+        utf8_string_view lookup_ordinal(const uint32_t _Ordinal) const noexcept;
+
+        // decodes the value of the message with the specified qualified ID into _Value, fails if not found
+        bool lookup(const utf8_string_view _Id, utf8_string& _Value) const;
+
+        // decodes the value of the message with the specified ID hash into _Value, fails if not found
+        bool lookup_hash(const uint64_t _Hash, utf8_string& _Value) const;
+
+        // decodes the value of the message with the specified ordinal into _Value, fails if not found
+        bool lookup_ordinal(const uint32_t _Ordinal, utf8_string& _Value) const;
+
+        // releases the UMC file
+        void close() noexcept;
+
+    private:
+        static constexpr uint32_t _Not_found = static_cast<uint32_t>(-1);
+        static constexpr size_t _Batch_size  = 16; // the number of lookups whose memory accesses overlap
+
+        // validates the header and locates the sections, fails if the file is malformed
+        bool _Parse();
+
+        // returns the size of a single lookup table entry
+        size_t _Entry_size() const noexcept;
+
+        // returns the size of a single value location
+        size_t _Location_size() const noexcept;
+
+        // returns the address of the hash stored in the specified lookup table entry
+        const byte_t* _Hash_address(const uint32_t _Idx) const noexcept;
+
+        // returns the hash stored in the specified lookup table entry
+        uint64_t _Hash_at(const uint32_t _Idx) const noexcept;
+
+        // returns the address of the value location stored in the specified lookup table entry
+        const byte_t* _Location_address(const uint32_t _Idx) const noexcept;
+
+        // returns the index of the lookup table entry with the specified hash
+        uint32_t _Find(const uint64_t _Hash) const noexcept;
+
+        // returns the value described by the specified lookup table entry, empty if the value is compressed
+        utf8_string_view _Value_at(const uint32_t _Idx) const noexcept;
+
+        // decodes the value described by the specified lookup table entry into _Value
+        bool _Decode_at(const uint32_t _Idx, utf8_string& _Value) const;
+
+        // returns the specified block index entry
+        _Block_index_entry _Block_at(const uint32_t _Idx) const noexcept;
+
+        // decompresses the block that contains the value and copies the value into _Value
+        bool _Decode_from_block(const uint64_t _Offset, const uint32_t _Length, utf8_string& _Value) const;
+
+        // finds the lookup table entries of at most _Batch_size hashes, the searches are interleaved
+        void _Find_batch(const uint64_t* const _Hashes, const size_t _Count, uint32_t* const _Indexes) const noexcept;
+
+        // resolves the values of at most _Batch_size hashes, prefetching the memory each step will touch
+        void _Lookup_batch(
+            const uint64_t* const _Hashes, const size_t _Count, utf8_string_view* const _Values) const noexcept;
+
+        // Note: The reader is immutable once the file is opened, and all lookups only read the mapped
+        //       file contents, so they are lock-free and can be performed from any number of threads.
+        //       The returned values point directly into the mapped file and remain valid until it is closed,
+        //       while the compressed values are decoded into the buffers supplied by the caller.
+        mapped_file _Myfile;
+        utf8_string_view _Mylang;
+        uint32_t _Mylcid;
+        uint32_t _Mycount;
+        byte_t _Myflags;
+        uint64_t _Myseed; // perfect hash index seed
+        uint32_t _Mybuckets; // perfect hash index buckets
+        uint32_t _Myordinals; // the number of ordinals, zero if the values are not indexed by ordinals
+        const byte_t* _Mypilots; // perfect hash index pilots, null if there is no index
+        const byte_t* _Myhashes; // lookup table entries, or the hashes if they are stored separately, null
+                                 // if the values are indexed by ordinals
+        const byte_t* _Mylocations; // value locations, null if they are stored along with the hashes
+        const byte_t* _Myblocks; // block index entries, null if the blob is not compressed in blocks
+        uint32_t _Myblock_count;
+        byte_string_view _Myblob;
+        fsst_table _Mytable; // symbol table, empty if the values are not compressed
+        vector<uint32_t> _Myorder; // entries ordered by hashes, used only if the lookup table is neither
+                                   // sorted nor indexed
+    };
+} // namespace mjx
+
+#endif // _ULPCL_UMC_READER_HPP_
\ No newline at end of file
@@ -0,0 +1,266 @@
+// xxh3.hpp
+
+// Copyright (c) Mateusz Jandura. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+#ifndef _ULPCL_XXH3_HPP_
+#define _ULPCL_XXH3_HPP_
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <xxhash/xxhash.h>
+
+namespace mjx {
+    struct _Xxh3_traits { // constant-evaluated XXH3-64 with the default secret and no seed
+        static constexpr uint32_t _Prime32_1 = 0x9E37'79B1;
+        static constexpr uint32_t _Prime32_2 = 0x85EB'CA77;
+        static constexpr uint32_t _Prime32_3 = 0xC2B2'AE3D;
+        static constexpr uint64_t _Prime64_1 = 0x9E37'79B1'85EB'CA87;
+        static constexpr uint64_t _Prime64_2 = 0xC2B2'AE3D'27D4'EB4F;
+        static constexpr uint64_t _Prime64_3 = 0x1656'67B1'9E37'79F9;
+        static constexpr uint64_t _Prime64_4 = 0x85EB'CA77'C2B2'AE63;
+        static constexpr uint64_t _Prime64_5 = 0x27D4'EB2F'1656'67C5;
+        static constexpr uint64_t _Prime_mx1 = 0x1656'6791'9E37'79F9;
+        static constexpr uint64_t _Prime_mx2 = 0x9FB2'1C65'1E98'DF25;
+
+        static constexpr size_t _Stripe_length       = 64;
+        static constexpr size_t _Secret_consume_rate = 8;
+        static constexpr size_t _Secret_size         = 192;
+        static constexpr size_t _Secret_size_min     = 136;
+        static constexpr size_t _Midsize_max         = 240;
+
+        static constexpr unsigned char _Secret[_Secret_size] = {
+            0xB8, 0xFE, 0x6C, 0x39, 0x23, 0xA4, 0x4B, 0xBE, 0x7C, 0x01, 0x81, 0x2C, 0xF7, 0x21, 0xAD, 0x1C,
+            0xDE, 0xD4, 0x6D, 0xE9, 0x83, 0x90, 0x97, 0xDB, 0x72, 0x40, 0xA4, 0xA4, 0xB7, 0xB3, 0x67, 0x1F,
+            0xCB, 0x79, 0xE6, 0x4E, 0xCC, 0xC0, 0xE5, 0x78, 0x82, 0x5A, 0xD0, 0x7D, 0xCC, 0xFF, 0x72, 0x21,
+            0xB8, 0x08, 0x46, 0x74, 0xF7, 0x43, 0x24, 0x8E, 0xE0, 0x35, 0x90, 0xE6, 0x81, 0x3A, 0x26, 0x4C,
+            0x3C, 0x28, 0x52, 0xBB, 0x91, 0xC3, 0x00, 0xCB, 0x88, 0xD0, 0x65, 0x8B, 0x1B, 0x53, 0x2E, 0xA3,
+            0x71, 0x64, 0x48, 0x97, 0xA2, 0x0D, 0xF9, 0x4E, 0x38, 0x19, 0xEF, 0x46, 0xA9, 0xDE, 0xAC, 0xD8,
+            0xA8, 0xFA, 0x76, 0x3F, 0xE3, 0x9C, 0x34, 0x3F, 0xF9, 0xDC, 0xBB, 0xC7, 0xC7, 0x0B, 0x4F, 0x1D,
+            0x8A, 0x51, 0xE0, 0x4B, 0xCD, 0xB4, 0x59, 0x31, 0xC8, 0x9F, 0x7E, 0xC9, 0xD9, 0x78, 0x73, 0x64,
+            0xEA, 0xC5, 0xAC, 0x83, 0x34, 0xD3, 0xEB, 0xC3, 0xC5, 0x81, 0xA0, 0xFF, 0xFA, 0x13, 0x63, 0xEB,
+            0x17, 0x0D, 0xDD, 0x51, 0xB7, 0xF0, 0xDA, 0x49, 0xD3, 0x16, 0x55, 0x26, 0x29, 0xD4, 0x68, 0x9E,
+            0x2B, 0x16, 0xBE, 0x58, 0x7D, 0x47, 0xA1, 0xFC, 0x8F, 0xF8, 0xB8, 0xD1, 0x7A, 0xD0, 0x31, 0xCE,
+            0x45, 0xCB, 0x3A, 0x8F, 0x95, 0x16, 0x04, 0x28, 0xAF, 0xD7, 0xFB, 0xCA, 0xBB, 0x4B, 0x40, 0x7E
+        };
+
+        // reads a little-endian 32-bit integer byte by byte
+        template <class _Elem>
+        static constexpr uint32_t _Read32(const _Elem* const _Ptr) noexcept {
+            uint32_t _Value = 0;
+            for (size_t _Idx = 0; _Idx < 4; ++_Idx) {
+                _Value |= static_cast<uint32_t>(static_cast<unsigned char>(_Ptr[_Idx])) << (_Idx * 8);
+            }
+
+            return _Value;
+        }
+
+        // reads a little-endian 64-bit integer byte by byte
+        template <class _Elem>
+        static constexpr uint64_t _Read64(const _Elem* const _Ptr) noexcept {
+            return static_cast<uint64_t>(_Read32(_Ptr)) | (static_cast<uint64_t>(_Read32(_Ptr + 4)) << 32);
+        }
+
+        static constexpr uint64_t _Rotl64(const uint64_t _Value, const int _Shift) noexcept {
+            return (_Value << _Shift) | (_Value >> (64 - _Shift));
+        }
+
+        static constexpr uint64_t _Swap64(const uint64_t _Value) noexcept {
+            uint64_t _Result = 0;
+            for (size_t _Idx = 0; _Idx < 8; ++_Idx) {
+                _Result = (_Result << 8) | ((_Value >> (_Idx * 8)) & 0xFF);
+            }
+
+            return _Result;
+        }
+
+        // multiplies two 64-bit integers and folds the 128-bit product into 64 bits
+        static constexpr uint64_t _Mul128_fold64(const uint64_t _Left, const uint64_t _Right) noexcept {
+            const uint64_t _Lo_lo = (_Left & 0xFFFF'FFFF) * (_Right & 0xFFFF'FFFF);
+            const uint64_t _Hi_lo = (_Left >> 32) * (_Right & 0xFFFF'FFFF);
+            const uint64_t _Lo_hi = (_Left & 0xFFFF'FFFF) * (_Right >> 32);
+            const uint64_t _Hi_hi = (_Left >> 32) * (_Right >> 32);
+            const uint64_t _Cross = (_Lo_lo >> 32) + (_Hi_lo & 0xFFFF'FFFF) + _Lo_hi;
+            const uint64_t _Upper = (_Hi_lo >> 32) + (_Cross >> 32) + _Hi_hi;
+            const uint64_t _Lower = (_Cross << 32) | (_Lo_lo & 0xFFFF'FFFF);
+            return _Lower ^ _Upper;
+        }
+
+        static constexpr uint64_t _Xxh64_avalanche(uint64_t _Hash) noexcept {
+            _Hash ^= _Hash >> 33;
+            _Hash *= _Prime64_2;
+            _Hash ^= _Hash >> 29;
+            _Hash *= _Prime64_3;
+            _Hash ^= _Hash >> 32;
+            return _Hash;
+        }
+
+        static constexpr uint64_t _Avalanche(uint64_t _Hash) noexcept {
+            _Hash ^= _Hash >> 37;
+            _Hash *= _Prime_mx1;
+            _Hash ^= _Hash >> 32;
+            return _Hash;
+        }
+
+        static constexpr uint64_t _Rrmxmx(uint64_t _Hash, const size_t _Size) noexcept {
+            _Hash ^= _Rotl64(_Hash, 49) ^ _Rotl64(_Hash, 24);
+            _Hash *= _Prime_mx2;
+            _Hash ^= (_Hash >> 35) + _Size;
+            _Hash *= _Prime_mx2;
+            return _Hash ^ (_Hash >> 28);
+        }
+
+        template <class _Elem>
+        static constexpr uint64_t _Mix16(const _Elem* const _Data, const size_t _Secret_off) noexcept {
+            return _Mul128_fold64(_Read64(_Data) ^ _Read64(_Secret + _Secret_off),
+                _Read64(_Data + 8) ^ _Read64(_Secret + _Secret_off + 8));
+        }
+
+        template <class _Elem>
+        static constexpr uint64_t _Hash_short(const _Elem* const _Data, const size_t _Size) noexcept {
+            if (_Size > 8) { // 9 to 16 bytes
+                const uint64_t _Lo = _Read64(_Data) ^ (_Read64(_Secret + 24) ^ _Read64(_Secret + 32));
+                const uint64_t _Hi = _Read64(_Data + _Size - 8) ^ (_Read64(_Secret + 40) ^ _Read64(_Secret + 48));
+                return _Avalanche(_Size + _Swap64(_Lo) + _Hi + _Mul128_fold64(_Lo, _Hi));
+            }
+
+            if (_Size >= 4) { // 4 to 8 bytes
+                const uint64_t _Input = _Read32(_Data + _Size - 4) + (static_cast<uint64_t>(_Read32(_Data)) << 32);
+                return _Rrmxmx(_Input ^ (_Read64(_Secret + 8) ^ _Read64(_Secret + 16)), _Size);
+            }
+
+            if (_Size > 0) { // 1 to 3 bytes
+                const uint32_t _Combined = (static_cast<uint32_t>(static_cast<unsigned char>(_Data[0])) << 16)
+                    | (static_cast<uint32_t>(static_cast<unsigned char>(_Data[_Size >> 1])) << 24)
+                    | static_cast<uint32_t>(static_cast<unsigned char>(_Data[_Size - 1]))
+                    | (static_cast<uint32_t>(_Size) << 8);
+                return _Xxh64_avalanche(_Combined ^ static_cast<uint64_t>(_Read32(_Secret) ^ _Read32(_Secret + 4)));
+            }
+
+            return _Xxh64_avalanche(_Read64(_Secret + 56) ^ _Read64(_Secret + 64));
+        }
+
+        template <class _Elem>
+        static constexpr uint64_t _Hash_medium(const _Elem* const _Data, const size_t _Size) noexcept {
+            uint64_t _Acc = _Size * _Prime64_1;
+            if (_Size <= 128) { // 17 to 128 bytes, mix pairs of 16-byte blocks from both ends
+                if (_Size > 32) {
+                    if (_Size > 64) {
+                        if (_Size > 96) {
+                            _Acc += _Mix16(_Data + 48, 96);
+                            _Acc += _Mix16(_Data + _Size - 64, 112);
+                        }
+
+                        _Acc += _Mix16(_Data + 32, 64);
+                        _Acc += _Mix16(_Data + _Size - 48, 80);
+                    }
+
+                    _Acc += _Mix16(_Data + 16, 32);
+                    _Acc += _Mix16(_Data + _Size - 32, 48);
+                }
+
+                _Acc += _Mix16(_Data, 0);
+                _Acc += _Mix16(_Data + _Size - 16, 16);
+                return _Avalanche(_Acc);
+            }
+
+            // 129 to 240 bytes
+            for (size_t _Idx = 0; _Idx < 8; ++_Idx) {
+                _Acc += _Mix16(_Data + 16 * _Idx, 16 * _Idx);
+            }
+
+            _Acc                 = _Avalanche(_Acc);
+            const size_t _Rounds = _Size / 16;
+            for (size_t _Idx = 8; _Idx < _Rounds; ++_Idx) {
+                _Acc += _Mix16(_Data + 16 * _Idx, 16 * (_Idx - 8) + 3);
+            }
+
+            _Acc += _Mix16(_Data + _Size - 16, _Secret_size_min - 17);
+            return _Avalanche(_Acc);
+        }
+
+        template <class _Elem>
+        static constexpr void _Accumulate512(
+            uint64_t* const _Acc, const _Elem* const _Data, const size_t _Secret_off) noexcept {
+            for (size_t _Idx = 0; _Idx < 8; ++_Idx) {
+                const uint64_t _Value = _Read64(_Data + 8 * _Idx);
+                const uint64_t _Key   = _Value ^ _Read64(_Secret + _Secret_off + 8 * _Idx);
+                _Acc[_Idx ^ 1]       += _Value;
+                _Acc[_Idx]           += (_Key & 0xFFFF'FFFF) * (_Key >> 32);
+            }
+        }
+
+        static constexpr void _Scramble(uint64_t* const _Acc) noexcept {
+            for (size_t _Idx = 0; _Idx < 8; ++_Idx) {
+                uint64_t _Value = _Acc[_Idx];
+                _Value         ^= _Value >> 47;
+                _Value         ^= _Read64(_Secret + _Secret_size - _Stripe_length + 8 * _Idx);
+                _Acc[_Idx]      = _Value * _Prime32_1;
+            }
+        }
+
+        template <class _Elem>
+        static constexpr uint64_t _Hash_long(const _Elem* const _Data, const size_t _Size) noexcept {
+            constexpr size_t _Stripes_per_block = (_Secret_size - _Stripe_length) / _Secret_consume_rate;
+            constexpr size_t _Block_length      = _Stripe_length * _Stripes_per_block;
+            uint64_t _Acc[8] = {_Prime32_3, _Prime64_1, _Prime64_2, _Prime64_3, _Prime64_4, _Prime32_2, _Prime64_5,
+                _Prime32_1};
+            const size_t _Blocks = (_Size - 1) / _Block_length;
+            for (size_t _Block = 0; _Block < _Blocks; ++_Block) {
+                for (size_t _Stripe = 0; _Stripe < _Stripes_per_block; ++_Stripe) {
+                    _Accumulate512(_Acc, _Data + _Block * _Block_length + _Stripe * _Stripe_length,
+                        _Stripe * _Secret_consume_rate);
+                }
+
+                _Scramble(_Acc);
+            }
+
+            // the last partial block and the last stripe, which may overlap the previous ones
+            const size_t _Stripes = ((_Size - 1) - _Blocks * _Block_length) / _Stripe_length;
+            for (size_t _Stripe = 0; _Stripe < _Stripes; ++_Stripe) {
+                _Accumulate512(_Acc, _Data + _Blocks * _Block_length + _Stripe * _Stripe_length,
+                    _Stripe * _Secret_consume_rate);
+            }
+
+            _Accumulate512(_Acc, _Data + _Size - _Stripe_length, _Secret_size - _Stripe_length - 7);
+            uint64_t _Result = _Size * _Prime64_1;
+            for (size_t _Idx = 0; _Idx < 4; ++_Idx) {
+                _Result += _Mul128_fold64(
+                    _Acc[2 * _Idx] ^ _Read64(_Secret + 11 + 16 * _Idx),
+                    _Acc[2 * _Idx + 1] ^ _Read64(_Secret + 11 + 16 * _Idx + 8));
+            }
+
+            return _Avalanche(_Result);
+        }
+
+        template <class _Elem>
+        static constexpr uint64_t _Hash(const _Elem* const _Data, const size_t _Size) noexcept {
+            if (_Size <= 16) {
+                return _Hash_short(_Data, _Size);
+            } else if (_Size <= _Midsize_max) {
+                return _Hash_medium(_Data, _Size);
+            } else {
+                return _Hash_long(_Data, _Size);
+            }
+        }
+    };
+
+    // Note: The compiler identifies each message by the XXH3-64 hash of its qualified ID, computed with
+    //       the default secret and no seed. This function computes the same hash, at compile time if
+    //       possible, so that the IDs known in advance don't have to be hashed at runtime.
+    constexpr uint64_t xxh3_64(const char* const _Data, const size_t _Size) noexcept {
+        if (::std::is_constant_evaluated()) {
+            return _Xxh3_traits::_Hash(_Data, _Size);
+        } else { // use the vectorized implementation
+            return ::XXH3_64bits(_Data, _Size);
+        }
+    }
+
+    template <size_t _Size>
+    constexpr uint64_t xxh3_64(const char (&_Str)[_Size]) noexcept { // hashes a string literal
+        return ::mjx::xxh3_64(_Str, _Size - 1); // skip the null-terminator
+    }
+} // namespace mjx
+
+#endif // _ULPCL_XXH3_HPP_
\ No newline at end of file